@@ -6,14 +6,33 @@
 #define BEHAVIOR_H
 
 #include <vector>
+#include <chrono>
+#include <cstdint>
 #include <SDL.h>
 
+#include "inputBackend.h"
+
 using ChannelDataType = int;
 
 enum class InputMode {
     set, increment, toggle, toggle_symmetric, SIZE
 };
 
+// Which event family a button or axis binding listens to. Game controllers report through both the
+// controller mapping and the raw joystick, with different button and axis numbers.
+enum class InputSource {
+    controller, joystick, hat, keyboard, SIZE
+};
+
+// Behaviors that act over time instead of once per event
+enum class TimedMode {
+    repeat,         // applies on press, then again every interval after an initial delay while held
+    double_tap,     // applies on the second press within the window
+    long_press,     // applies once the input was held for the duration
+    sequence,       // applies a list of steps at fixed delays after the press
+    SIZE
+};
+
 enum class AxisAsButton {
     no, up, down, SIZE
 };
@@ -25,6 +44,8 @@ public:
     void operator() (std::vector<ChannelDataType> &channels) const;
 
     int channel_index;
+    std::chrono::milliseconds pulse{0};     // when set, the channel returns to 0 this long after the behavior applied
+    std::uint64_t modifiers = 0;            // modifier layer the behavior belongs to, see Inputs::modifier()
 
     // Getter functions for protected members
     double getValue() const { return value; }
@@ -56,15 +77,28 @@ public:
 
     AxisBehavior(int channel_index, double value, Uint8 button, Uint16 which, AxisAsButton as_button=AxisAsButton::no, double threshold = 0, InputMode mode=InputMode::set);
 
-    void operator() (std::vector<ChannelDataType> &channels, Sint32 value);
+    // Returns true when the behavior applied, i.e. always for analog axes and on threshold crossings otherwise.
+    // The axis' previous value is kept by the caller, behaviors are shared read-only between cycles.
+    bool operator() (std::vector<ChannelDataType> &channels, Sint32 value, Sint32 previous_value) const;
     AxisAsButton as_button;    // 0 means not digital, +1 means in response to rising signal, -1 means in response to falling signal
     double threshold;
+};
 
-protected:
-    // for digital input
-    double previous_value_scaled=0;
+
+struct TimedStep {
+    std::chrono::milliseconds delay;        // after the press
+    double value;
+    InputMode mode = InputMode::set;
 };
 
+class TimedBehavior : public InputBehavior {
+public:
+    TimedBehavior(int channel_index, double value, TimedMode timed_mode, std::chrono::milliseconds duration, std::chrono::milliseconds interval = std::chrono::milliseconds(0), InputMode mode=InputMode::set);
 
+    TimedMode timed_mode;
+    std::chrono::milliseconds duration;     // repeat delay, double tap window or long press time
+    std::chrono::milliseconds interval;     // repeat period
+    std::vector<TimedStep> steps;           // sequence only
+};
 
 #endif //BEHAVIOR_H
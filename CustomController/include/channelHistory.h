@@ -0,0 +1,59 @@
+//
+// Lock-free per-channel history ring with min/max decimated views for scope plots
+//
+
+#ifndef CHANNELHISTORY_H
+#define CHANNELHISTORY_H
+
+#include "behavior.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One writer (the cycle loop) appends a frame per cycle and never waits. Readers decimate any channel
+// to min/max pairs per pixel while writing goes on.
+// Samples are stored channel-major, so decimating one channel reads contiguous memory, and every
+// block_size samples also keep their min/max. Wide buckets read those summaries instead of the raw samples.
+class ChannelHistory {
+public:
+    static constexpr std::size_t block_size = 32;
+
+    // capacity is in frames and is rounded up to a whole number of blocks
+    ChannelHistory(int n_channels, std::size_t capacity);
+
+    void push(const ChannelDataType *frame);
+
+    void push(const std::vector<ChannelDataType> &frame) { push(frame.data()); }
+
+    std::uint64_t written() const { return n_written.load(std::memory_order_acquire); }
+
+    int channels() const { return n_channels; }
+
+    std::size_t capacity() const { return capacity_frames; }
+
+    // Splits the newest n_samples frames of a channel into width buckets and writes each bucket's min and
+    // max into the caller's buffers (width entries each), oldest bucket first. Returns the index of the first
+    // bucket that is valid: older buckets are missing from the history or were overwritten while reading.
+    std::size_t decimate(int channel_index, std::size_t n_samples, std::size_t width, ChannelDataType *out_min, ChannelDataType *out_max) const;
+
+private:
+    struct alignas(64) Lane {
+        std::unique_ptr<std::atomic<ChannelDataType>[]> samples;
+        std::unique_ptr<std::atomic<ChannelDataType>[]> block_min;
+        std::unique_ptr<std::atomic<ChannelDataType>[]> block_max;
+    };
+
+    int n_channels;
+    std::size_t capacity_frames;
+    std::vector<Lane> lanes;
+    std::vector<ChannelDataType> running_min;   // writer-side min/max of the block being written
+    std::vector<ChannelDataType> running_max;
+    alignas(64) std::atomic<std::uint64_t> n_written{0};
+
+    void bucketRange(const Lane &lane, std::uint64_t begin, std::uint64_t end, ChannelDataType &min, ChannelDataType &max) const;
+};
+
+#endif //CHANNELHISTORY_H
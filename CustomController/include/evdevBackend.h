@@ -0,0 +1,116 @@
+//
+// Linux evdev input backend reading /dev/input/event* through epoll
+//
+
+#ifndef EVDEVBACKEND_H
+#define EVDEVBACKEND_H
+
+#ifdef __linux__
+
+#include "inputBackend.h"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include <linux/input.h>
+
+// Reads struct input_event records directly from the kernel, skipping SDL's buffering and polling thread.
+// Records are translated into the SDL events Inputs already dispatches:
+//  - on gamepads (devices reporting BTN_GAMEPAD) BTN_SOUTH...BTN_THUMBR and the main sticks/triggers become
+//    controller buttons/axes and ABS_HAT0 becomes the controller d-pad buttons,
+//  - everything else becomes joystick buttons, axes and hats, numbered the way SDL numbers them for the same
+//    node so bindings captured through SdlBackend keep working,
+//  - on fds that are not evdev nodes buttons (BTN_0..., BTN_TRIGGER..., BTN_SOUTH..., BTN_DPAD_*,
+//    BTN_TRIGGER_HAPPY*) are numbered densely in that order, axes by their evdev code, and keyboard keys
+//    become key events for the keys SDL has a keycode for.
+// Every opened device is announced with SDL_JOYDEVICEADDED carrying its instance id, see backend_device_ids.
+// Event timestamps are the kernel's, taken on CLOCK_MONOTONIC so they share steady_clock's epoch.
+// Any file descriptor carrying input_event records works, e.g. a pipe, so the backend runs without hardware.
+class EvdevBackend : public InputBackend {
+public:
+    EvdevBackend();
+
+    ~EvdevBackend() override;
+
+    EvdevBackend(const EvdevBackend &) = delete;
+    EvdevBackend &operator=(const EvdevBackend &) = delete;
+
+    // Opens an evdev node, returns the instance id used as 'which' in its events or -1 on failure
+    SDL_JoystickID openDevice(const std::string &path);
+
+    // Opens every /dev/input/event* reporting gamepad or joystick buttons, returns the number opened
+    int openJoysticks();
+
+    enum class DeviceKind {
+        detect,     // gamepad if an evdev node reports BTN_GAMEPAD, a fd that is not an evdev node is a gamepad
+        gamepad,
+        joystick
+    };
+
+    // Reads input_event records from fd. Axis ranges are taken from EVIOCGABS when fd is an evdev node,
+    // otherwise values are assumed to be Sint16 already. Returns the instance id or -1 on failure.
+    SDL_JoystickID addDevice(int fd, bool owns_fd = true, SDL_JoystickID which = -1, DeviceKind kind = DeviceKind::detect);
+
+    void removeDevice(SDL_JoystickID which);
+
+    std::vector<SDL_JoystickID> devices() const;
+
+    bool pollEvent(SDL_Event &event, InputClock::time_point &timestamp) override;
+
+    void flush() override;
+
+    std::uint64_t droppedReports() const { return dropped_reports; }
+
+private:
+    struct AxisRange {
+        int min = -32768;
+        int max = 32767;
+    };
+
+    struct Device {
+        int fd = -1;
+        bool owns_fd = false;
+        SDL_JoystickID which = -1;
+        bool is_evdev = false;
+        bool gamepad = false;               // read through the controller mapping rather than as a joystick
+        bool syncing = false;               // discarding events after SYN_DROPPED until the next SYN_REPORT
+        std::array<AxisRange, ABS_CNT> ranges{};
+        std::array<int, ABS_CNT> axis_index{};  // joystick axis, or hat for ABS_HAT*, of each code, -1 if absent
+        std::vector<int> button_index;      // joystick button of each key code, empty when not an evdev node
+        std::array<int, ABS_HAT3Y - ABS_HAT0X + 1> hat{};  // last ABS_HAT0X ... ABS_HAT3Y direction
+        std::vector<std::uint8_t> partial;  // bytes of an incomplete record (pipes may split them)
+    };
+
+    struct PendingEvent {
+        SDL_Event event;
+        InputClock::time_point timestamp;
+    };
+
+    int epoll_fd;
+    std::vector<Device> open_devices;
+    std::deque<PendingEvent> pending;
+    SDL_JoystickID next_which = backend_device_ids;
+    std::uint64_t dropped_reports = 0;
+
+    void readDevice(Device &device);
+
+    void translate(Device &device, const input_event &record);
+
+    void resyncAxes(Device &device, InputClock::time_point timestamp);
+
+    void pushAxis(Device &device, int code, int value, InputClock::time_point timestamp);
+
+    void pushHat(Device &device, int code, int value, InputClock::time_point timestamp);
+
+    void pushButton(const Device &device, Uint32 type, Uint8 button, bool pressed, InputClock::time_point timestamp);
+
+    void closeDevice(Device &device);
+
+    static SDL_Keycode keycodeFromEvdev(int code);
+};
+
+#endif //__linux__
+
+#endif //EVDEVBACKEND_H
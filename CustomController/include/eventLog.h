@@ -0,0 +1,69 @@
+//
+// Timestamped event logs: recording live input and replaying it through Inputs
+//
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "inputBackend.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <SDL.h>
+
+struct LoggedEvent {
+    std::int64_t at_ns;         // since the start of the recording
+    SDL_Event event;
+};
+
+using EventLog = std::vector<LoggedEvent>;
+
+// Binary file: an 8 byte magic, the record count, then the records as they are in memory.
+// Logs are meant to be replayed on the machine type they were recorded on.
+bool saveEventLog(const std::string &path, const EventLog &log);
+
+bool loadEventLog(const std::string &path, EventLog &log);
+
+// Hands out the logged events that are due at the current replay time, without touching the SDL event queue
+class ReplayBackend : public InputBackend {
+public:
+    // Event at_ns is replayed at start + at_ns
+    ReplayBackend(const EventLog &log, InputClock::time_point start) : log(log), start(start) {}
+
+    void setTime(InputClock::time_point now) { this->now = now; }
+
+    bool pollEvent(SDL_Event &event, InputClock::time_point &timestamp) override;
+
+    // Skips the events due so far
+    void flush() override;
+
+    bool finished() const { return next == log.size(); }
+
+private:
+    const EventLog &log;
+    InputClock::time_point start;
+    InputClock::time_point now{};
+    std::size_t next = 0;
+};
+
+// Passes events through from another backend and appends them to a log
+class RecordingBackend : public InputBackend {
+public:
+    explicit RecordingBackend(InputBackend &source, InputClock::time_point start = InputClock::now()) : source(source), start(start) {}
+
+    bool pollEvent(SDL_Event &event, InputClock::time_point &timestamp) override;
+
+    void flush() override { source.flush(); }
+
+    const EventLog &log() const { return recorded; }
+
+    EventLog take() { return std::move(recorded); }
+
+private:
+    InputBackend &source;
+    InputClock::time_point start;
+    EventLog recorded;
+};
+
+#endif //EVENTLOG_H
@@ -0,0 +1,66 @@
+//
+// Single-producer / single-consumer event queue used by EventRouter
+//
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <SDL.h>
+
+#include "inputBackend.h"
+
+// Lock-free ring buffer of SDL events. One thread pushes (the router), one thread pops (the Inputs instance).
+// When the consumer falls behind, the producer holds events back in a backlog of its own instead of blocking:
+//  - releases, device added/removed and quit are always kept, a lost release would latch a channel,
+//  - axis and hat motions replace the held back motion of the same axis or hat, only the latest value matters,
+//  - presses are dropped and counted once the backlog holds as many events as the ring.
+// Held back events go in, in order, at the next push() or retry().
+class EventQueue : public InputBackend {
+public:
+    explicit EventQueue(std::size_t capacity = 1024);
+
+    // Producer side. Returns false when the event was dropped or replaced a held back one.
+    bool push(const SDL_Event &event, InputClock::time_point timestamp = InputClock::now());
+
+    // Producer side, moves held back events into the ring as far as it has room
+    void retry();
+
+    bool pop(SDL_Event &event, InputClock::time_point &timestamp);
+
+    bool pollEvent(SDL_Event &event, InputClock::time_point &timestamp) override { return pop(event, timestamp); }
+
+    void flush() override { clear(); }
+
+    // Consumer side, events the producer still holds back arrive later
+    void clear();
+
+    // Events in the ring, not the held back ones
+    std::size_t size() const;
+
+    std::uint64_t dropped() const { return dropped_count.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        SDL_Event event;
+        InputClock::time_point timestamp;
+    };
+
+    std::vector<Entry> buffer;
+    std::size_t mask;
+    std::deque<Entry> backlog;      // owned by the producer
+
+    bool write(const Entry &entry);
+
+    void hold(const Entry &entry);
+
+    alignas(64) std::atomic<std::size_t> head{0};    // next slot to read, owned by the consumer
+    alignas(64) std::atomic<std::size_t> tail{0};    // next slot to write, owned by the producer
+    alignas(64) std::atomic<std::uint64_t> dropped_count{0};
+};
+
+#endif //EVENTQUEUE_H
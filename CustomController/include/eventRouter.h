@@ -0,0 +1,88 @@
+//
+// Routes the global SDL event queue to several Inputs instances
+//
+
+#ifndef EVENTROUTER_H
+#define EVENTROUTER_H
+
+#include "eventQueue.h"
+#include "rateScheduler.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <SDL.h>
+
+class Inputs;
+
+// SDL has a single event queue per process, so only one place may call SDL_PollEvent.
+// The router drains it once per pump() and hands every event to the queue of each Inputs instance that owns it:
+//  - controller / joystick events go to the instances that claimed the device (instance id),
+//  - keyboard events go to the instances that claimed the key,
+//  - unclaimed input events, SDL_QUIT and device added/removed events go to every attached instance.
+// Each Inputs instance then drains its own queue from its own thread, at its own rate.
+class EventRouter {
+public:
+    EventRouter() = default;
+
+    ~EventRouter();
+
+    EventRouter(const EventRouter &) = delete;
+    EventRouter &operator=(const EventRouter &) = delete;
+
+    // Creates a queue for the instance and makes it its input backend instead of SDL. The router must outlive the instance's polling.
+    EventQueue &attach(Inputs &inputs, std::size_t queue_capacity = 1024);
+
+    void detach(Inputs &inputs);
+
+    void claimDevice(Inputs &inputs, SDL_JoystickID which);
+
+    void claimKey(Inputs &inputs, SDL_Keycode key);
+
+    void release(Inputs &inputs);
+
+    // Drains the SDL event queue once and routes every event, from one thread at a time (start() or the caller).
+    // Returns the number of events read from SDL.
+    std::size_t pump();
+
+    // Pumps from a background thread at a fixed rate
+    void start(double rate_hz = 1000);
+
+    void stop();
+
+    RateStats pumpStats() const { return pump_scheduler.stats(); }
+
+    std::uint64_t unrouted() const { return unrouted_count.load(std::memory_order_relaxed); }
+
+private:
+    struct Route {
+        Inputs *inputs;
+        std::unique_ptr<EventQueue> queue;
+    };
+
+    struct PumpedEvent {
+        SDL_Event event;
+        InputClock::time_point timestamp;
+    };
+
+    std::mutex routes_mutex;
+    std::vector<Route> routes;
+    std::vector<PumpedEvent> pumped;    // reused by every pump(), only one thread pumps
+    std::unordered_map<SDL_JoystickID, std::vector<EventQueue*>> device_owners;
+    std::unordered_map<SDL_Keycode, std::vector<EventQueue*>> key_owners;
+
+    RateScheduler pump_scheduler;
+    std::atomic<std::uint64_t> unrouted_count{0};
+
+    EventQueue *queueOf(const Inputs &inputs);
+
+    void broadcast(const SDL_Event &event, InputClock::time_point timestamp);
+
+    void deliver(const std::vector<EventQueue*> &owners, const SDL_Event &event, InputClock::time_point timestamp);
+
+    void forget(EventQueue *queue);
+};
+
+#endif //EVENTROUTER_H
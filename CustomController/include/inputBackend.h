@@ -0,0 +1,51 @@
+//
+// Sources of input events for Inputs
+//
+
+#ifndef INPUTBACKEND_H
+#define INPUTBACKEND_H
+
+#include <chrono>
+#include <SDL.h>
+
+using InputClock = std::chrono::steady_clock;
+
+// Devices a backend opens itself get instance ids from here on, clear of SDL's own. Their SDL_JOYDEVICEADDED
+// carries that instance id instead of an SDL device index.
+constexpr SDL_JoystickID backend_device_ids = 0x10000;
+
+// Everything Inputs dispatches arrives through a backend as SDL events, so key, button and axis behaviors
+// work the same whatever the source. The timestamp tells when the input happened, as close to the source as
+// the backend can observe it.
+class InputBackend {
+public:
+    virtual ~InputBackend() = default;
+
+    // Takes the next pending event, returns false when none is pending
+    virtual bool pollEvent(SDL_Event &event, InputClock::time_point &timestamp) = 0;
+
+    // Discards pending events
+    virtual void flush() {
+        SDL_Event event;
+        InputClock::time_point timestamp;
+        while (pollEvent(event, timestamp)) {}
+    }
+};
+
+// Reads SDL's own event queue
+class SdlBackend : public InputBackend {
+public:
+    bool pollEvent(SDL_Event &event, InputClock::time_point &timestamp) override {
+        if (!SDL_PollEvent(&event)) {
+            return false;
+        }
+        timestamp = InputClock::now();  // SDL only keeps millisecond ticks
+        return true;
+    }
+
+    void flush() override {
+        SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+    }
+};
+
+#endif //INPUTBACKEND_H
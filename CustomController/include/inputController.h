@@ -5,24 +5,63 @@
 #ifndef INPUTCONTROLLER_H
 #define INPUTCONTROLLER_H
 #include "behavior.h"
+#include "inputBackend.h"
+#include "inputStats.h"
+#include "channelHistory.h"
+#include "timingWheel.h"
+#include "snapshotPublisher.h"
 
 #include <vector>
 #include <SDL.h>
 #include <string>
 #include <iostream>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
 
 enum class ChannelBoundType {
     clamp, free, modulo, loop //, bounce
 };
 
+// How the constructor and SDL_JOYDEVICEADDED open devices
+enum class DeviceOpening {
+    eager,          // opened right away, the constructor returns once every device is open
+    background,     // opened on a helper thread and taken over by the next cycle, cycles run meanwhile
+    none,           // no SDL device access at all, events only come from the backend (offline replay)
+};
+
+// Durations used by the tap, release and timed behaviors
+struct TimingConfig {
+    std::chrono::milliseconds pulse{100};               // tap and release output width
+    std::chrono::milliseconds repeat_delay{400};
+    std::chrono::milliseconds repeat_interval{100};
+    std::chrono::milliseconds double_tap_window{300};
+    std::chrono::milliseconds long_press{600};
+};
+
 class Inputs {
 public:
-    Inputs(int n_channels);
+    Inputs(int n_channels, DeviceOpening device_opening=DeviceOpening::eager);
 
     ~Inputs();
 
     bool cycle();
 
+    // Runs a cycle at the given time instead of the clock's, for replaying recorded events faster than real time
+    bool cycle(InputClock::time_point now);
+
+    // Cancels running pulses and timed behaviors and starts timing at 'start'. Two instances restarted at the same
+    // time and cycled at the same times expire their timers in the same cycles.
+    void restartTimers(InputClock::time_point start);
+
     bool cycle(std::vector<ChannelDataType> &channel_buffer);
 
     std::vector<ChannelDataType> getChannels() const;
@@ -31,6 +70,85 @@ public:
 
     std::vector<ChannelBoundType> channel_bounds;
 
+    // Reads events from another backend, e.g. a routed queue (see EventRouter) or evdev. nullptr restores SDL polling.
+    // Safe while another thread cycles: returns once nothing reads the previous backend any more, so it can be
+    // destroyed right after.
+    void setBackend(InputBackend *backend);
+
+    // Takes the next pending event from the backend
+    bool pollEvent(SDL_Event &event);
+
+    // Discards pending events without dispatching them
+    void flushEvents();
+
+    // Appends every cycle's output frame to the history, nullptr stops recording
+    void setHistory(ChannelHistory *history) { this->history = history; }
+
+    // Counters can be read from any thread while the loop keeps running
+    InputStatsSnapshot statsSnapshot() const { return stats.snapshot(); }
+
+    void resetStats() { stats.reset(); }
+
+    // Modifiers: every key or button used as a modifier gets one of 64 bits, the held ones form a mask.
+    // Returns the modifier's bit, 0 when all 64 are taken.
+    std::uint64_t modifier(const SDL_Keycode &key) { return modifierBit(bindingKey(key)); }
+
+    std::uint64_t modifier(const Uint8 &button, const SDL_JoystickID &which, InputSource source=InputSource::controller) { return modifierBit(bindingKey(source, which, button)); }
+
+    // Behaviors added afterwards belong to this layer: they only apply while exactly these modifiers are held,
+    // among the modifiers used by any behavior of the same input. 0 is the base layer.
+    void setBindingModifiers(std::uint64_t modifiers) { binding_modifiers = modifiers; }
+
+    std::uint64_t heldModifiers() const { return held_modifiers; }
+
+    // Edits go to a copy of the behavior tables that is published as a whole, the cycle picks it up at its start
+    // without ever waiting. Every add* and clear publishes on its own, unless enclosed in beginEdit() and commitEdit().
+    // Edits can run on another thread than the cycles, from one thread at a time.
+    void beginEdit() { ++edit_depth; }
+
+    void commitEdit();
+
+    // Applies to behaviors added afterwards
+    void setTiming(const TimingConfig &timing) { this->timing = timing; }
+
+    const TimingConfig &getTiming() const { return timing; }
+
+    // Output value of every channel when its raw value is zero
+    std::vector<ChannelDataType> getNeutralChannels() const { return channel_biases; }
+
+    // Update groups: a channel is output only in cycles where its group is due, in between getChannels() keeps
+    // returning its previous value. Events, cycle behaviors and bounds still run every cycle for every group, so groups
+    // thin out the frames sinks get, not the work of a cycle. The cycle rate sets the latency of every group and
+    // should be the fastest group's rate. Every channel starts in group 0, a group without a rate is
+    // due every cycle. Like the behaviors, groups are published with the edits and survive clear().
+    static constexpr int max_update_groups = 64;
+    static constexpr std::uint64_t all_groups = ~0ull;
+
+    void setChannelGroup(int channel_index, int group);
+
+    // 0 updates the group every cycle
+    void setGroupRate(int group, double rate_hz);
+
+    int channelGroup(int channel_index) const;
+
+    double groupRate(int group) const;
+
+    // Bit per group the last cycle updated, all_groups while no group with a channel has a rate
+    std::uint64_t freshGroups() const { return fresh_groups; }
+
+    bool deviceConnected(SDL_JoystickID which) const { return device_last_input.contains(which); }
+
+    // Devices found but still being opened in the background
+    std::size_t devicesPending() const { return devices_opening.size(); }
+
+    bool devicePending(SDL_JoystickID which) const { return devices_opening.contains(which); }
+
+    // Time of the last event from the device, default constructed when it has not sent anything yet
+    InputClock::time_point lastDeviceInput(SDL_JoystickID which) const {
+        auto found = device_last_input.find(which);
+        return found == device_last_input.end() ? InputClock::time_point{} : found->second;
+    }
+
     // Functions for JSON serialization
     // bool saveToJson(const std::string& filename) const;
     // bool loadFromJson(const std::string& filename);
@@ -38,48 +156,261 @@ public:
 protected:
     std::vector<int> gamepad_indices;
     std::vector<SDL_GameController*> gamepads;
+    std::unordered_map<SDL_JoystickID, InputClock::time_point> device_last_input;   // connected devices only
 
     std::vector<ChannelDataType> channels_raw;
     std::vector<ChannelDataType> channel_biases;  // Per-channel biases
     std::vector<ChannelDataType> channel_limits;  // Per-channel limits
 
-    std::vector<InputBehavior> cycle_behaviors;
-    std::vector<KeyBehavior> key_down_behaviors;
-    std::vector<KeyBehavior> key_up_behaviors;
-    std::vector<ButtonBehavior> button_up_behaviors;
-    std::vector<ButtonBehavior> button_down_behaviors;
-    std::vector<AxisBehavior> axis_behaviors;
+    // Behaviors are grouped by the input that triggers them, so an event only visits its own behaviors
+    template<typename Behavior>
+    using BindingTable = std::unordered_map<std::uint64_t, std::vector<Behavior>>;
+
+    struct ChannelReset {
+        std::uint64_t sequence;
+        int channel_index;          // all_channels for clear()
+        double value;
+    };
+    static constexpr int all_channels = -1;
+
+    // Everything the add* and clear functions configure. A published snapshot is never modified again, cycles read
+    // it without locking while edits build the next one.
+    struct BehaviorTables {
+        std::vector<InputBehavior> cycle_behaviors;
+        std::unordered_map<SDL_Keycode, std::vector<KeyBehavior>> key_down_behaviors;
+        std::unordered_map<SDL_Keycode, std::vector<KeyBehavior>> key_up_behaviors;
+        BindingTable<ButtonBehavior> button_up_behaviors;
+        BindingTable<ButtonBehavior> button_down_behaviors;
+        BindingTable<AxisBehavior> axis_behaviors;
+
+        // Modifier layers. A trigger's layer mask holds every modifier any of its behaviors uses, the active layer of
+        // an event is the held modifiers & mask and selects behaviors by equality, whatever the number of chords.
+        std::unordered_map<std::uint64_t, Uint8> modifier_bits;             // input -> bit index
+        std::unordered_map<std::uint64_t, std::uint64_t> layer_masks;       // trigger -> modifiers used on it
+
+        // Timed behaviors are stored once and referenced by id from the inputs that trigger them
+        std::unordered_map<std::uint32_t, TimedBehavior> timed_behaviors;
+        BindingTable<std::uint32_t> timed_press_triggers;
+        BindingTable<std::uint32_t> timed_release_triggers;
+
+        // Channel values set by edits, applied once by the first cycle that sees them. Kept until a cycle did,
+        // so a snapshot replaced before any cycle ran does not lose them.
+        std::vector<ChannelReset> resets;
+
+        // Update groups, not bindings, so clear() keeps them
+        std::vector<Uint8> channel_groups;                          // per channel, empty while all are in group 0
+        std::array<double, max_update_groups> group_rates{};        // Hz, 0 for every cycle
+        std::uint64_t rated_groups = 0;                             // groups with a rate
+        std::uint64_t used_groups = 1;                              // groups with a channel
+    };
+
+    // Edit side
+    BehaviorTables editing;
+    std::uint64_t binding_modifiers = 0;
+    std::uint32_t next_timed_id = 1;
+    std::uint64_t next_reset = 1;
+    int edit_depth = 0;
+
+    SnapshotPublisher<BehaviorTables> published;
+    std::atomic<std::uint64_t> applied_reset{0};            // written by cycles, read by edits to drop old resets
+
+    // Cycle side
+    const BehaviorTables *behaviors;
+
+    struct TimedState {
+        TimingWheel::TimerId timer = 0;
+        InputClock::time_point last_press{};
+        std::size_t next_step = 0;
+    };
+    std::unordered_map<std::uint32_t, TimedState> timed_states;             // by timed behavior id
+    std::unordered_map<std::uint64_t, Sint32> axis_values;                  // last value per axis
+    std::unordered_map<std::uint64_t, std::uint64_t> press_layers;          // trigger -> layer when it was pressed
+    std::unordered_map<std::uint64_t, std::bitset<256>> pressed_buttons;    // per device and source, by button
+    std::uint64_t held_modifiers = 0;
+    std::array<InputClock::time_point, max_update_groups> group_due{};    // next update of the rated groups
+    std::uint64_t fresh_groups = all_groups;
+    std::vector<ChannelDataType> channels_out;                            // bounded values of the last updates
+
+    // Publishes the edits unless a beginEdit() is open
+    void edited();
+
+    void resetChannel(int channel_index, double value);
+
+    // Takes over the latest snapshot at the start of a cycle
+    void adoptBehaviors();
+
+    std::uint64_t modifierBit(std::uint64_t input);
+
+    void trackModifier(std::uint64_t input, bool pressed);
+
+    std::uint64_t pressLayer(std::uint64_t trigger);
+
+    std::uint64_t releaseLayer(std::uint64_t trigger);
+
+    std::uint64_t activeLayer(std::uint64_t trigger) const {
+        auto found = behaviors->layer_masks.find(trigger);
+        return found == behaviors->layer_masks.end() ? 0 : held_modifiers & found->second;
+    }
+
+    void rebuildLayers();
+
+    // Applies the behaviors of the given layer, returns how many
+    template<typename Behavior>
+    int applyLayer(const std::vector<Behavior> &behaviors, std::uint64_t layer);
+
+    template<typename Behavior, typename... Args>
+    Behavior &bind(std::vector<Behavior> &behaviors, std::uint64_t trigger, Args&&... args) {
+        Behavior &behavior = behaviors.emplace_back(std::forward<Args>(args)...);
+        behavior.modifiers = binding_modifiers;
+        if (binding_modifiers) {
+            editing.layer_masks[trigger] |= binding_modifiers;
+        }
+        return behavior;
+    }
+
+    // Pulse ends and timed behavior steps expire on the wheel, independent of the cycle rate
+    TimingWheel timers;
+    std::vector<TimingWheel::TimerId> pulse_timers;         // per channel, 0 when no pulse is running
+    InputClock::time_point event_time;                      // timestamp of the event being dispatched
+    TimingConfig timing;
+
+    static constexpr std::uint64_t pulse_timer = 1ull << 56;
+    static constexpr std::uint64_t timed_timer = 2ull << 56;
+
+    std::vector<SDL_Joystick*> joysticks;                     // devices without a game controller mapping
+
+    // Background device opening
+    struct OpenedDevice {
+        SDL_JoystickID which;
+        int device_index;
+        SDL_GameController *gamepad;
+        SDL_Joystick *joystick;
+    };
+    DeviceOpening device_opening;
+    std::unordered_set<SDL_JoystickID> devices_opening;      // requested, not yet taken over
+    std::thread device_opener;
+    std::mutex opener_mutex;
+    std::condition_variable opener_wake;
+    std::vector<SDL_JoystickID> open_requests;              // guarded by opener_mutex
+    std::vector<OpenedDevice> opened_devices;               // guarded by opener_mutex
+    std::atomic<bool> devices_opened{false};
+    bool opener_stopping = false;
+
+    void openerLoop();
+
+    void adoptOpenedDevices();
+
+    void adoptDevice(const OpenedDevice &device);
+
+    static void closeDevice(const OpenedDevice &device);
+    std::unordered_map<std::uint64_t, Uint8> hat_states;     // last SDL_HAT_* mask per device and hat
+
+    static std::uint64_t bindingKey(InputSource source, SDL_JoystickID which, Uint8 index) {
+        return (static_cast<std::uint64_t>(source) << 40) | (static_cast<std::uint64_t>(static_cast<Uint32>(which)) << 8) | index;
+    }
+
+    static std::uint64_t bindingKey(const SDL_Keycode &key) {
+        return (static_cast<std::uint64_t>(InputSource::keyboard) << 40) | static_cast<Uint32>(key);
+    }
+
+    template<typename Table>
+    static void eraseChannel(Table &table, int channel_index) {
+        for (auto &[key, behaviors] : table) {
+            std::erase_if(behaviors, [channel_index](const InputBehavior &input_behavior) {return input_behavior.channel_index == channel_index;});
+        }
+        std::erase_if(table, [](const auto &entry) {return entry.second.empty();});
+    }
+
+    SdlBackend sdl_backend;
+    std::atomic<InputBackend*> backend{&sdl_backend};
+    std::atomic<InputBackend*> backend_in_use{nullptr};     // announced by the reading thread, as a hazard pointer
+
+    // Announces the current backend before using it, checked again so a replaced one is never read
+    InputBackend *acquireBackend();
+
+    void releaseBackend() { backend_in_use.store(nullptr); }
+
+    InputStats stats;
+
+    ChannelHistory *history = nullptr;
+    std::vector<ChannelDataType> output_frame;
+
+    bool runCycle(InputClock::time_point now, InputClock::time_point started);
+
+    // Groups due at 'now', moving their next update on
+    std::uint64_t dueGroups(InputClock::time_point now);
+
+    ChannelDataType boundChannel(int channel_index, ChannelDataType raw);
 
     bool processEvents();
 
-    void keyDown(const SDL_Keycode &key);
+    bool dispatchEvent(const SDL_Event &event, InputClock::time_point timestamp);
+
+    void countTriggered(int n_behaviors);
+
+    // Applies a behavior and starts its pulse if it has one
+    void apply(const InputBehavior &input_behavior);
+
+    void startPulse(int channel_index, std::chrono::milliseconds duration);
+
+    void timerExpired(std::uint64_t payload);
+
+    int timedPress(std::uint64_t trigger, std::uint64_t layer);
+
+    int timedRelease(std::uint64_t trigger);
+
+    void addTimed(std::uint64_t trigger, TimedBehavior timed_behavior);
+
+    void eraseTimed(int channel_index);
+
+    void deviceAdded(int device_index);
+
+    void deviceRemoved(const SDL_JoystickID &which);
 
-    void keyUp(const SDL_Keycode &key);
+    int keyDown(const SDL_Keycode &key);
 
-    void controllerButtonDown(const Uint8 &button, const SDL_JoystickID &which);
+    int keyUp(const SDL_Keycode &key);
 
-    void controllerButtonUp(const Uint8 &button, const SDL_JoystickID &which);
+    int buttonDown(InputSource source, const Uint8 &button, const SDL_JoystickID &which);
 
-    void controllerAxisMotion(const Uint8 &axis, const Sint16 &value, const SDL_JoystickID &which);
+    int buttonUp(InputSource source, const Uint8 &button, const SDL_JoystickID &which);
+
+    int axisMotion(InputSource source, const Uint8 &axis, const Sint16 &value, const SDL_JoystickID &which);
+
+    int hatMotion(const Uint8 &hat, const Uint8 &value, const SDL_JoystickID &which);
 
 public:
+    // Hat directions are bound like buttons of InputSource::hat, numbered 4 per hat in SDL_HAT_UP, RIGHT, DOWN, LEFT order
+    static Uint8 hatButton(Uint8 hat, Uint8 direction) {
+        Uint8 bit = direction & SDL_HAT_RIGHT ? 1 : direction & SDL_HAT_DOWN ? 2 : direction & SDL_HAT_LEFT ? 3 : 0;
+        return hat * 4 + bit;
+    }
+
     void clear() {
-        cycle_behaviors.clear();
-        key_down_behaviors.clear();
-        key_up_behaviors.clear();
-        button_up_behaviors.clear();
-        button_down_behaviors.clear();
-        axis_behaviors.clear();
+        stats.countConfigRebuild();
+        BehaviorTables kept;
+        kept.resets = std::move(editing.resets);
+        kept.channel_groups = std::move(editing.channel_groups);
+        kept.group_rates = editing.group_rates;
+        kept.rated_groups = editing.rated_groups;
+        kept.used_groups = editing.used_groups;
+        editing = std::move(kept);
+        resetChannel(all_channels, 0);
+        edited();
     }
 
     void clear(int channel_index) {
-        std::erase_if(cycle_behaviors, [channel_index](const InputBehavior &input_behavior) {return input_behavior.channel_index == channel_index;});
-        std::erase_if(key_down_behaviors, [channel_index](const InputBehavior &input_behavior) {return input_behavior.channel_index == channel_index;});
-        std::erase_if(key_up_behaviors, [channel_index](const InputBehavior &input_behavior) {return input_behavior.channel_index == channel_index;});
-        std::erase_if(button_down_behaviors, [channel_index](const InputBehavior &input_behavior) {return input_behavior.channel_index == channel_index;});
-        std::erase_if(button_up_behaviors, [channel_index](const InputBehavior &input_behavior) {return input_behavior.channel_index == channel_index;});
-        std::erase_if(axis_behaviors, [channel_index](const InputBehavior &input_behavior) {return input_behavior.channel_index == channel_index;});
-        channels_raw.at(channel_index) = 0; // Reset channel value
+        stats.countConfigRebuild();
+        std::erase_if(editing.cycle_behaviors, [channel_index](const InputBehavior &input_behavior) {return input_behavior.channel_index == channel_index;});
+        eraseChannel(editing.key_down_behaviors, channel_index);
+        eraseChannel(editing.key_up_behaviors, channel_index);
+        eraseChannel(editing.button_down_behaviors, channel_index);
+        eraseChannel(editing.button_up_behaviors, channel_index);
+        eraseChannel(editing.axis_behaviors, channel_index);
+        eraseTimed(channel_index);
+        rebuildLayers();
+        resetChannel(channel_index, 0); // Reset channel value
+        edited();
     }
 
     void add(int channel_index, const SDL_Keycode &key, double value, InputMode mode=InputMode::set, bool on_release=false) {
@@ -89,100 +420,159 @@ public:
         }
 
         if (key==SDLK_UNKNOWN) {
-            cycle_behaviors.emplace_back(channel_index, value, mode);
+            editing.cycle_behaviors.emplace_back(channel_index, value, mode);
         } else if (on_release) {
-            key_up_behaviors.emplace_back(channel_index, value, key, mode);
+            bind(editing.key_up_behaviors[key], bindingKey(key), channel_index, value, key, mode);
         } else {
-            key_down_behaviors.emplace_back(channel_index, value, key, mode);
+            bind(editing.key_down_behaviors[key], bindingKey(key), channel_index, value, key, mode);
         }
+        edited();
     }
 
     void addTap(int channel_index, const SDL_Keycode &key, double value) {
-        key_down_behaviors.emplace_back(channel_index, value, key);
-        cycle_behaviors.emplace_back(channel_index, 0);
+        bind(editing.key_down_behaviors[key], bindingKey(key), channel_index, value, key).pulse = timing.pulse;
+        edited();
     }
 
     void addRelease(int channel_index, const SDL_Keycode &key, double value) {
-        key_up_behaviors.emplace_back(channel_index, value, key);
-        cycle_behaviors.emplace_back(channel_index, 0);
+        bind(editing.key_up_behaviors[key], bindingKey(key), channel_index, value, key).pulse = timing.pulse;
+        edited();
     }
 
     void addHold(int channel_index, const SDL_Keycode &key, double value) {
-        key_down_behaviors.emplace_back(channel_index, value, key);
-        key_up_behaviors.emplace_back(channel_index, 0, key);
+        bind(editing.key_down_behaviors[key], bindingKey(key), channel_index, value, key);
+        bind(editing.key_up_behaviors[key], bindingKey(key), channel_index, 0, key);
+        edited();
     }
 
     void addIncrement(int channel_index, const SDL_Keycode &key, double value) {
-        key_down_behaviors.emplace_back(channel_index, value, key, InputMode::increment);
+        bind(editing.key_down_behaviors[key], bindingKey(key), channel_index, value, key, InputMode::increment);
+        edited();
     }
 
     void addToggle(int channel_index, const SDL_Keycode &key, double value) {
-        key_down_behaviors.emplace_back(channel_index, value, key, InputMode::toggle);
+        bind(editing.key_down_behaviors[key], bindingKey(key), channel_index, value, key, InputMode::toggle);
+        edited();
     }
 
     void addToggleSymmetric(int channel_index, const SDL_Keycode &key, double value) {
-        key_down_behaviors.emplace_back(channel_index, value, key, InputMode::toggle_symmetric);
-        channels_raw.at(channel_index) = value;
+        bind(editing.key_down_behaviors[key], bindingKey(key), channel_index, value, key, InputMode::toggle_symmetric);
+        resetChannel(channel_index, value);
+        edited();
+    }
+
+    void addRepeat(int channel_index, const SDL_Keycode &key, double value, InputMode mode=InputMode::increment) {
+        addTimed(bindingKey(key), TimedBehavior(channel_index, value, TimedMode::repeat, timing.repeat_delay, timing.repeat_interval, mode));
+        edited();
+    }
+
+    void addDoubleTap(int channel_index, const SDL_Keycode &key, double value, InputMode mode=InputMode::toggle) {
+        addTimed(bindingKey(key), TimedBehavior(channel_index, value, TimedMode::double_tap, timing.double_tap_window, std::chrono::milliseconds(0), mode));
+        edited();
+    }
+
+    void addLongPress(int channel_index, const SDL_Keycode &key, double value, InputMode mode=InputMode::toggle) {
+        addTimed(bindingKey(key), TimedBehavior(channel_index, value, TimedMode::long_press, timing.long_press, std::chrono::milliseconds(0), mode));
+        edited();
+    }
+
+    void addSequence(int channel_index, const SDL_Keycode &key, std::vector<TimedStep> steps) {
+        TimedBehavior timed_behavior(channel_index, 0, TimedMode::sequence, std::chrono::milliseconds(0));
+        timed_behavior.steps = std::move(steps);
+        addTimed(bindingKey(key), std::move(timed_behavior));
+        edited();
+    }
+
+    void addTap(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value, InputSource source=InputSource::controller) {
+        bind(editing.button_down_behaviors[bindingKey(source, which, button)], bindingKey(source, which, button), channel_index, value, button, which).pulse = timing.pulse;
+        edited();
+    }
+
+    void addRelease(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value, InputSource source=InputSource::controller) {
+        bind(editing.button_up_behaviors[bindingKey(source, which, button)], bindingKey(source, which, button), channel_index, value, button, which).pulse = timing.pulse;
+        edited();
+    }
+
+    void addHold(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value, InputSource source=InputSource::controller) {
+        bind(editing.button_down_behaviors[bindingKey(source, which, button)], bindingKey(source, which, button), channel_index, value, button, which);
+        bind(editing.button_up_behaviors[bindingKey(source, which, button)], bindingKey(source, which, button), channel_index, 0, button, which);
+        edited();
+    }
+
+    void addIncrement(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value, InputSource source=InputSource::controller) {
+        bind(editing.button_down_behaviors[bindingKey(source, which, button)], bindingKey(source, which, button), channel_index, value, button, which, InputMode::increment);
+        edited();
     }
 
-    void addTap(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value) {
-        button_down_behaviors.emplace_back(channel_index, value, button, which);
-        cycle_behaviors.emplace_back(channel_index, 0);
+    void addToggle(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value, InputSource source=InputSource::controller) {
+        bind(editing.button_down_behaviors[bindingKey(source, which, button)], bindingKey(source, which, button), channel_index, value, button, which, InputMode::toggle);
+        edited();
     }
 
-    void addRelease(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value) {
-        button_up_behaviors.emplace_back(channel_index, value, button, which);
-        cycle_behaviors.emplace_back(channel_index, 0);
+    void addToggleSymmetric(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value, InputSource source=InputSource::controller) {
+        bind(editing.button_down_behaviors[bindingKey(source, which, button)], bindingKey(source, which, button), channel_index, value, button, which, InputMode::toggle_symmetric);
+        resetChannel(channel_index, value);
+        edited();
     }
 
-    void addHold(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value) {
-        button_down_behaviors.emplace_back(channel_index, value, button, which);
-        button_up_behaviors.emplace_back(channel_index, 0, button, which);
+    void addRepeat(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value, InputMode mode=InputMode::increment, InputSource source=InputSource::controller) {
+        addTimed(bindingKey(source, which, button), TimedBehavior(channel_index, value, TimedMode::repeat, timing.repeat_delay, timing.repeat_interval, mode));
+        edited();
     }
 
-    void addIncrement(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value) {
-        button_down_behaviors.emplace_back(channel_index, value, button, which, InputMode::increment);
+    void addDoubleTap(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value, InputMode mode=InputMode::toggle, InputSource source=InputSource::controller) {
+        addTimed(bindingKey(source, which, button), TimedBehavior(channel_index, value, TimedMode::double_tap, timing.double_tap_window, std::chrono::milliseconds(0), mode));
+        edited();
     }
 
-    void addToggle(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value) {
-        button_down_behaviors.emplace_back(channel_index, value, button, which, InputMode::toggle);
+    void addLongPress(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value, InputMode mode=InputMode::toggle, InputSource source=InputSource::controller) {
+        addTimed(bindingKey(source, which, button), TimedBehavior(channel_index, value, TimedMode::long_press, timing.long_press, std::chrono::milliseconds(0), mode));
+        edited();
     }
 
-    void addToggleSymmetric(int channel_index, const Uint8 &button, const SDL_JoystickID &which, double value) {
-        button_down_behaviors.emplace_back(channel_index, value, button, which, InputMode::toggle_symmetric);
-        channels_raw.at(channel_index) = value;
+    void addSequence(int channel_index, const Uint8 &button, const SDL_JoystickID &which, std::vector<TimedStep> steps, InputSource source=InputSource::controller) {
+        TimedBehavior timed_behavior(channel_index, 0, TimedMode::sequence, std::chrono::milliseconds(0));
+        timed_behavior.steps = std::move(steps);
+        addTimed(bindingKey(source, which, button), std::move(timed_behavior));
+        edited();
     }
 
-    void addAxis(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, AxisAsButton as_button=AxisAsButton::no, double threshold = 0, InputMode mode=InputMode::set) {
-        axis_behaviors.emplace_back(channel_index, value, axis, which, as_button, threshold, mode);
+    void addAxis(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, AxisAsButton as_button=AxisAsButton::no, double threshold = 0, InputMode mode=InputMode::set, InputSource source=InputSource::controller) {
+        bind(editing.axis_behaviors[bindingKey(source, which, axis)], bindingKey(source, which, axis), channel_index, value, axis, which, as_button, threshold, mode);
+        edited();
     }
 
-    void addAxisTap(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0) {
-        axis_behaviors.emplace_back(channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::set);
-        cycle_behaviors.emplace_back(channel_index, 0);
+    void addAxisTap(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0, InputSource source=InputSource::controller) {
+        bind(editing.axis_behaviors[bindingKey(source, which, axis)], bindingKey(source, which, axis), channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::set).pulse = timing.pulse;
+        edited();
     }
 
-    void addAxisHold(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0) {
-        axis_behaviors.emplace_back(channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::set);
-        axis_behaviors.emplace_back(channel_index, 0, axis, which, AxisAsButton::up, threshold, InputMode::set);
+    void addAxisHold(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0, InputSource source=InputSource::controller) {
+        bind(editing.axis_behaviors[bindingKey(source, which, axis)], bindingKey(source, which, axis), channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::set);
+        bind(editing.axis_behaviors[bindingKey(source, which, axis)], bindingKey(source, which, axis), channel_index, 0, axis, which, AxisAsButton::up, threshold, InputMode::set);
+        edited();
     }
 
-    void addAxisRelease(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0) {
-        axis_behaviors.emplace_back(channel_index, value, axis, which, AxisAsButton::up, threshold, InputMode::set);
-        axis_behaviors.emplace_back(channel_index, 0, axis, which, AxisAsButton::down, threshold, InputMode::set);
+    void addAxisRelease(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0, InputSource source=InputSource::controller) {
+        bind(editing.axis_behaviors[bindingKey(source, which, axis)], bindingKey(source, which, axis), channel_index, value, axis, which, AxisAsButton::up, threshold, InputMode::set);
+        bind(editing.axis_behaviors[bindingKey(source, which, axis)], bindingKey(source, which, axis), channel_index, 0, axis, which, AxisAsButton::down, threshold, InputMode::set);
+        edited();
     }
 
-    void addAxisIncrement(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0) {
-        axis_behaviors.emplace_back(channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::increment);
+    void addAxisIncrement(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0, InputSource source=InputSource::controller) {
+        bind(editing.axis_behaviors[bindingKey(source, which, axis)], bindingKey(source, which, axis), channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::increment);
+        edited();
     }
 
-    void addAxisToggle(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0) {
-        axis_behaviors.emplace_back(channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::toggle);
+    void addAxisToggle(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0, InputSource source=InputSource::controller) {
+        bind(editing.axis_behaviors[bindingKey(source, which, axis)], bindingKey(source, which, axis), channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::toggle);
+        edited();
     }
 
-    void addAxisToggleSymmetric(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0) {
-        axis_behaviors.emplace_back(channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::toggle_symmetric);
-        channels_raw.at(channel_index) = value;
+    void addAxisToggleSymmetric(int channel_index, const Uint8 &axis, const SDL_JoystickID &which, double value, double threshold = 0, InputSource source=InputSource::controller) {
+        bind(editing.axis_behaviors[bindingKey(source, which, axis)], bindingKey(source, which, axis), channel_index, value, axis, which, AxisAsButton::down, threshold, InputMode::toggle_symmetric);
+        resetChannel(channel_index, value);
+        edited();
     }
 
 };
@@ -0,0 +1,81 @@
+//
+// Runtime performance counters of the input engine
+//
+
+#ifndef INPUTSTATS_H
+#define INPUTSTATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class StatEvent {
+    quit, key_down, key_up, controller_button_down, controller_button_up, controller_axis, joystick, device, other, SIZE
+};
+
+struct InputStatsSnapshot {
+    std::array<std::uint64_t, static_cast<std::size_t>(StatEvent::SIZE)> events{};   // per SDL event type
+    std::uint64_t events_ignored = 0;       // events that triggered no behavior
+    std::uint64_t behaviors_evaluated = 0;
+    std::uint64_t cycles = 0;
+    double cycle_min_us = 0;
+    double cycle_avg_us = 0;
+    double cycle_max_us = 0;
+    std::vector<std::uint64_t> clamps;      // per channel
+    std::vector<std::uint64_t> wraps;       // per channel, modulo and loop bounds
+    std::uint64_t config_rebuilds = 0;
+
+    static const char *eventName(StatEvent event);
+};
+
+// Every counter has a single writer (the thread running Inputs::cycle, or the configuring thread for
+// config_rebuilds), so increments are a relaxed load and store and never a locked read-modify-write.
+// snapshot() may be called from any thread while the loop keeps running.
+class InputStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit InputStats(int n_channels);
+
+    void countEvent(StatEvent event) { bump(events[static_cast<std::size_t>(event)]); }
+
+    void countIgnored() { bump(events_ignored); }
+
+    void countBehaviors(std::uint64_t n) { add(behaviors_evaluated, n); }
+
+    void countClamp(int channel_index) { bump(clamps[channel_index]); }
+
+    void countWrap(int channel_index) { bump(wraps[channel_index]); }
+
+    void countConfigRebuild() { config_rebuilds.fetch_add(1, std::memory_order_relaxed); }
+
+    void countCycle(Clock::duration duration);
+
+    InputStatsSnapshot snapshot() const;
+
+    void reset();
+
+private:
+    int n_channels;
+    std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(StatEvent::SIZE)> events{};
+    std::atomic<std::uint64_t> events_ignored{0};
+    std::atomic<std::uint64_t> behaviors_evaluated{0};
+    std::atomic<std::uint64_t> cycles{0};
+    std::atomic<std::int64_t> cycle_min_ns{0};
+    std::atomic<std::int64_t> cycle_max_ns{0};
+    std::atomic<std::int64_t> cycle_total_ns{0};
+    std::unique_ptr<std::atomic<std::uint64_t>[]> clamps;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> wraps;
+    std::atomic<std::uint64_t> config_rebuilds{0};
+
+    static void bump(std::atomic<std::uint64_t> &counter) { add(counter, 1); }
+
+    static void add(std::atomic<std::uint64_t> &counter, std::uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+#endif //INPUTSTATS_H
@@ -0,0 +1,196 @@
+//
+// Virtual joysticks and game controllers driven with generated input, for stress tests without hardware
+//
+
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include "inputBackend.h"
+#include "rateScheduler.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include <SDL.h>
+
+enum class VirtualDeviceType {
+    joystick,       // raw joystick with the profile's axes, buttons and hats
+    gamepad,        // SDL_JOYSTICK_TYPE_GAMECONTROLLER with the standard layout, SDL maps it automatically
+    SIZE
+};
+
+enum class LoadInput {
+    axis, button, hat, SIZE
+};
+
+enum class WaveForm {
+    sine, ramp, square, random, SIZE
+};
+
+// Step of a scripted pattern, the script repeats once its last step ran
+struct ScriptStep {
+    std::chrono::microseconds at;       // since the start of the script
+    LoadInput input;
+    int index;
+    int value;                          // axis value, 0/1 for buttons, SDL_HAT_* mask for hats
+    int device = -1;                    // -1 for every device
+};
+
+struct LoadProfile {
+    int devices = 1;
+    VirtualDeviceType type = VirtualDeviceType::gamepad;
+    int axes = 6;                       // joystick layout, gamepads always have 6 axes, 15 buttons and no hat
+    int buttons = 16;
+    int hats = 1;
+
+    double update_hz = 1000;            // every axis of every device moves once per update
+    WaveForm wave = WaveForm::sine;
+    double wave_hz = 1;
+    double button_hz = 10;              // random button toggles per second and device
+    double hat_hz = 2;                  // random hat changes per second and device
+    std::vector<ScriptStep> script;     // replaces the generated patterns when not empty
+
+    double hotplug_hz = 0;              // one device is detached and attached again this often, round robin
+    std::uint32_t seed = 1;
+};
+
+struct LoadStats {
+    std::array<std::uint64_t, static_cast<std::size_t>(LoadInput::SIZE)> sent{};        // value changes set on the devices
+    std::array<std::uint64_t, static_cast<std::size_t>(LoadInput::SIZE)> received{};    // events observed for them
+    std::uint64_t unmatched = 0;        // observed values that were never sent or aged out of the history
+    std::uint64_t hotplugs = 0;
+    std::uint64_t latency_samples = 0;
+    double latency_p50_us = 0;
+    double latency_p99_us = 0;
+    double latency_max_us = 0;
+    double seconds = 0;
+    RateStats rate;
+
+    // Changes SDL coalesced or lost before they reached the observer
+    std::uint64_t dropped(LoadInput input) const {
+        std::size_t i = static_cast<std::size_t>(input);
+        return sent[i] > received[i] ? sent[i] - received[i] : 0;
+    }
+};
+
+// Script files hold one step per line: "<ms> axis|button|hat <index> <value> [device]", # starts a comment
+bool loadScript(const std::string &path, std::vector<ScriptStep> &script);
+
+// Attaches virtual devices through SDL_JoystickAttachVirtual and drives them from its own thread at the profile's
+// rate. SDL turns the changes into regular device events, so Inputs sees them like real hardware. Latency is the
+// time from setting a value to observe() seeing its event.
+class LoadGenerator {
+public:
+    explicit LoadGenerator(LoadProfile profile);
+
+    ~LoadGenerator();
+
+    LoadGenerator(const LoadGenerator&) = delete;
+    LoadGenerator &operator=(const LoadGenerator&) = delete;
+
+    // Attaches the devices, they are enumerated once SDL pumps events. Returns false when SDL has no virtual driver.
+    bool attach();
+
+    void start();
+
+    void stop();
+
+    // Stops and detaches the devices
+    void detach();
+
+    // Instance ids of the attached devices, by slot
+    std::vector<SDL_JoystickID> devices() const;
+
+    const LoadProfile &profile() const { return config; }
+
+    // Call for every event taken from SDL, events of other devices are ignored
+    void observe(const SDL_Event &event, InputClock::time_point received);
+
+    LoadStats stats() const;
+
+    void resetStats();
+
+private:
+    static constexpr std::size_t history_size = 32;     // recent values per input, to match coalesced events
+
+    struct Sent {
+        int value = 0;
+        InputClock::time_point at{};
+        bool observed = false;
+    };
+
+    struct InputHistory {
+        std::array<Sent, history_size> sent{};
+        std::size_t next = 0;
+        int current = 0;
+
+        void push(int value, InputClock::time_point at) {
+            sent[next++ % history_size] = {value, at, false};
+            current = value;
+        }
+    };
+
+    struct Device {
+        SDL_Joystick *joystick = nullptr;
+        SDL_JoystickID which = -1;
+        std::vector<InputHistory> axes;
+        std::vector<InputHistory> buttons;
+        std::vector<InputHistory> hats;
+        std::mt19937 random;
+    };
+
+    LoadProfile config;
+    std::vector<Device> slots;
+    RateScheduler scheduler;
+    InputClock::time_point started{};
+    InputClock::time_point script_origin{};
+    std::size_t script_next = 0;
+    std::chrono::microseconds script_length{0};
+    double hotplug_credit = 0;
+    std::size_t hotplug_next = 0;
+
+    mutable std::mutex mutex;           // guards slots' ids and histories, and the counters below
+    LoadStats counters;
+    InputClock::time_point counting_since{};
+    std::vector<double> latencies_us;
+
+    bool attachSlot(Device &device);
+
+    void detachSlot(Device &device);
+
+    void tick();
+
+    void set(Device &device, LoadInput input, int index, int value, InputClock::time_point now);
+
+    void generate(Device &device, int slot, double t, InputClock::time_point now);
+
+    void runScript(InputClock::time_point now);
+
+    std::vector<InputHistory> *histories(Device &device, LoadInput input);
+};
+
+// Passes events through from another backend and shows them to a LoadGenerator on the way
+class LoadProbeBackend : public InputBackend {
+public:
+    LoadProbeBackend(InputBackend &source, LoadGenerator &generator) : source(source), generator(generator) {}
+
+    bool pollEvent(SDL_Event &event, InputClock::time_point &timestamp) override {
+        if (!source.pollEvent(event, timestamp)) {
+            return false;
+        }
+        generator.observe(event, timestamp);
+        return true;
+    }
+
+    void flush() override { source.flush(); }
+
+private:
+    InputBackend &source;
+    LoadGenerator &generator;
+};
+
+#endif //LOADGENERATOR_H
@@ -0,0 +1,117 @@
+//
+// Fans output frames out to several consumers, each on its own thread
+//
+
+#ifndef OUTPUTFANOUT_H
+#define OUTPUTFANOUT_H
+
+#include "behavior.h"
+#include "inputBackend.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What happens when a sink's queue is full
+enum class DropPolicy {
+    latest,     // the oldest queued frame is dropped, the consumer always gets the newest ones
+    block,      // publish() waits for the consumer, only for sinks that must see every frame
+    drop,       // the new frame is dropped and counted
+    SIZE
+};
+
+// Published once, shared read-only by every sink
+struct OutputFrame {
+    std::uint64_t sequence;
+    InputClock::time_point published;
+    std::vector<ChannelDataType> channels;
+    std::uint64_t fresh_groups = ~0ull;     // update groups (see Inputs) whose channels this frame updated
+};
+
+struct SinkConfig {
+    std::string name;
+    unsigned rate_divider = 1;      // deliver every n-th published frame
+    DropPolicy policy = DropPolicy::latest;
+    std::size_t queue_depth = 1;
+    std::uint64_t groups = ~0ull;   // only frames where one of these update groups is fresh, before the rate divider
+};
+
+struct SinkStats {
+    int id;
+    std::string name;
+    std::uint64_t offered = 0;      // frames after the rate divider
+    std::uint64_t delivered = 0;
+    std::uint64_t dropped = 0;
+    std::size_t queued = 0;
+    double mean_lag_us = 0;         // publish to consumer return
+    double max_lag_us = 0;
+};
+
+// publish() copies the frame once into a shared immutable buffer and queues a reference per sink, it never
+// runs a consumer itself. A slow consumer only fills its own queue, where its drop policy applies.
+class OutputFanout {
+public:
+    using Consumer = std::function<void(const OutputFrame&)>;
+
+    OutputFanout() = default;
+
+    ~OutputFanout();
+
+    OutputFanout(const OutputFanout &) = delete;
+    OutputFanout &operator=(const OutputFanout &) = delete;
+
+    // Starts the sink's thread, returns its id
+    int addSink(Consumer consumer, SinkConfig config = {});
+
+    // Delivers the frames already queued, then joins the thread
+    bool removeSink(int id);
+
+    void clear();
+
+    void publish(const std::vector<ChannelDataType> &channels, InputClock::time_point now = InputClock::now(), std::uint64_t fresh_groups = ~0ull);
+
+    std::vector<SinkStats> stats() const;
+
+    void resetStats();
+
+    std::size_t sinks() const;
+
+private:
+    struct Sink {
+        int id;
+        SinkConfig config;
+        Consumer consumer;
+        std::thread worker;
+
+        std::mutex queue_mutex;
+        std::condition_variable queue_filled;
+        std::condition_variable queue_drained;
+        std::deque<std::shared_ptr<const OutputFrame>> queue;
+        bool stopping = false;
+
+        std::uint64_t divider_count = 0;        // publisher only
+        std::atomic<std::uint64_t> offered{0};
+        std::atomic<std::uint64_t> delivered{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<std::int64_t> lag_sum_ns{0};
+        std::atomic<std::int64_t> lag_max_ns{0};
+
+        void run();
+    };
+
+    mutable std::mutex sinks_mutex;
+    std::vector<std::shared_ptr<Sink>> sink_list;      // shared with a publish() waiting on a full sink
+    int next_id = 1;
+    std::uint64_t sequence = 0;
+
+    static void stopSink(Sink &sink);
+};
+
+#endif //OUTPUTFANOUT_H
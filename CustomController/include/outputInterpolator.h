@@ -0,0 +1,98 @@
+//
+// Fixed rate output stage that interpolates between input frames
+//
+
+#ifndef OUTPUTINTERPOLATOR_H
+#define OUTPUTINTERPOLATOR_H
+
+#include "behavior.h"
+#include "inputBackend.h"
+#include "rateScheduler.h"
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+enum class InterpolationMode {
+    step,       // output follows the latest frame as is, the default: switches and pulses must not glide
+    linear,     // ramps to a new value over the measured input period
+    slew,       // moves toward the latest value at a limited rate
+    SIZE
+};
+
+// The input loop hands every bounded frame to setTarget(), at whatever rate and jitter events arrive.
+// sample() produces the output for any instant, so a sink can read frames at a higher fixed rate
+// (e.g. servo gimbals at 1 kHz) without seeing the input's step changes.
+// State is kept per channel in contiguous arrays and the modes are blended without branches,
+// so sampling a frame is a handful of vectorized passes over the channels.
+class OutputInterpolator {
+public:
+    explicit OutputInterpolator(int n_channels);
+
+    ~OutputInterpolator();
+
+    OutputInterpolator(const OutputInterpolator &) = delete;
+    OutputInterpolator &operator=(const OutputInterpolator &) = delete;
+
+    void setMode(int channel_index, InterpolationMode mode);
+
+    // Slew limit in channel units per second (default 4000), used by InterpolationMode::slew
+    void setSlewRate(int channel_index, double units_per_second);
+
+    // Longest ramp of InterpolationMode::linear, whatever the input period
+    void setMaxRamp(std::chrono::nanoseconds max_ramp);
+
+    // Latest frame of the input loop. Called once per cycle, only changed channels start a new ramp.
+    void setTarget(const std::vector<ChannelDataType> &frame, InputClock::time_point now = InputClock::now());
+
+    // Outputs the frame at once on every channel whatever its mode, e.g. failsafe values
+    void jumpTo(const std::vector<ChannelDataType> &frame, InputClock::time_point now = InputClock::now());
+
+    // Output frame at the given time, safe to call from another thread than setTarget
+    void sample(InputClock::time_point now, std::vector<ChannelDataType> &frame);
+
+    // Samples on its own thread at a fixed rate and passes every frame to the sink
+    void start(double rate_hz, std::function<void(const std::vector<ChannelDataType>&)> sink);
+
+    void setRate(double rate_hz) { scheduler.setRate(rate_hz); }
+
+    void stop();
+
+    bool running() const { return scheduler.running(); }
+
+    RateStats stats() const { return scheduler.stats(); }
+
+    int channels() const { return n_channels; }
+
+private:
+    int n_channels;
+    InputClock::time_point origin;
+    double max_ramp = 0.1;                  // seconds
+
+    std::mutex state_mutex;
+    // Per channel, times in seconds since origin
+    std::vector<double> target;
+    std::vector<double> from;               // ramp start value
+    std::vector<double> delta;              // ramp target - start
+    std::vector<double> ramp_start;
+    std::vector<double> ramp_rate;          // 1 / ramp duration
+    std::vector<double> slew_rate;
+    std::vector<double> output;             // last sampled value
+    std::vector<double> use_step;           // mode weights, exactly one of the three is 1
+    std::vector<double> use_linear;
+    std::vector<double> use_slew;
+    double last_sample = 0;
+    double last_target = 0;
+    double input_period = 0;                // smoothed time between setTarget calls
+    bool primed = false;
+
+    RateScheduler scheduler;
+    std::vector<ChannelDataType> sink_frame;
+    std::function<void(const std::vector<ChannelDataType>&)> sink;
+
+    double seconds(InputClock::time_point time) const {
+        return std::chrono::duration<double>(time - origin).count();
+    }
+};
+
+#endif //OUTPUTINTERPOLATOR_H
@@ -0,0 +1,104 @@
+//
+// Drift-free fixed rate scheduling on absolute deadlines
+//
+
+#ifndef RATESCHEDULER_H
+#define RATESCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+struct RateStats {
+    double target_hz = 0;
+    double achieved_hz = 0;         // over the last completed one second window
+    double mean_jitter_us = 0;      // mean absolute wake-up error over the same window
+    double max_jitter_us = 0;
+    std::uint64_t ticks = 0;
+    std::uint64_t missed = 0;       // deadlines skipped because a tick ran later than a whole period
+};
+
+// Deadline n lies at origin + n * period, computed in floating point nanoseconds.
+// Rounding never accumulates, so fractional millisecond periods (300 Hz, 400 Hz) average out exactly.
+class DeadlineClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit DeadlineClock(double rate_hz = 50);
+
+    // Changes the rate, continuing from the pending deadline
+    void setRate(double rate_hz);
+
+    double rate() const { return rate_hz.load(std::memory_order_relaxed); }
+
+    Clock::duration period() const { return std::chrono::nanoseconds(static_cast<std::int64_t>(period_ns.load(std::memory_order_relaxed))); }
+
+    void restart(Clock::time_point now = Clock::now());
+
+    Clock::time_point deadline() const { return deadlineAt(index); }
+
+    // Records the tick for the pending deadline ran at 'now' and moves to the next deadline after 'now'
+    void tick(Clock::time_point now = Clock::now());
+
+    RateStats stats() const;
+
+    void resetStats();
+
+private:
+    // Written by the ticking thread, read by rate(), period() and stats() from any other
+    std::atomic<double> rate_hz;
+    std::atomic<double> period_ns;
+    Clock::time_point origin;
+    std::uint64_t index = 0;
+
+    Clock::time_point window_start{};
+    std::uint64_t window_ticks = 0;
+    double window_jitter_sum_us = 0;
+    double window_jitter_max_us = 0;
+
+    std::atomic<double> achieved_hz{0};
+    std::atomic<double> mean_jitter_us{0};
+    std::atomic<double> max_jitter_us{0};
+    std::atomic<std::uint64_t> ticks{0};
+    std::atomic<std::uint64_t> missed{0};
+
+    Clock::time_point deadlineAt(std::uint64_t n) const {
+        return origin + std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(n) * period_ns.load(std::memory_order_relaxed) + 0.5));
+    }
+};
+
+// Runs a callback on its own thread at a fixed rate.
+// On Linux the thread sleeps with clock_nanosleep(TIMER_ABSTIME) on CLOCK_MONOTONIC, elsewhere with sleep_until.
+class RateScheduler {
+public:
+    RateScheduler() = default;
+
+    ~RateScheduler();
+
+    RateScheduler(const RateScheduler &) = delete;
+    RateScheduler &operator=(const RateScheduler &) = delete;
+
+    void start(double rate_hz, std::function<void()> callback);
+
+    // Safe to call from any thread, applied before the next deadline is computed
+    void setRate(double rate_hz);
+
+    void stop();
+
+    bool running() const { return active.load(std::memory_order_relaxed); }
+
+    RateStats stats() const { return clock.stats(); }
+
+    static void sleepUntil(DeadlineClock::Clock::time_point deadline);
+
+private:
+    DeadlineClock clock;
+    std::function<void()> callback;
+    std::thread worker;
+    std::atomic<bool> active{false};
+    std::atomic<double> requested_hz{0};
+};
+
+#endif //RATESCHEDULER_H
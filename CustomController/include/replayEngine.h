@@ -0,0 +1,117 @@
+//
+// Offline replay of event logs through two mappings, in parallel and faster than real time
+//
+
+#ifndef REPLAYENGINE_H
+#define REPLAYENGINE_H
+
+#include "eventLog.h"
+#include "inputController.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Runs independent tasks on a fixed set of threads. Every thread owns a deque of task indices and takes from
+// its back, and a thread whose deque ran dry steals from the front of another one, so long tasks (big logs)
+// do not leave the other cores idle.
+class WorkStealingPool {
+public:
+    // 0 uses every hardware thread
+    explicit WorkStealingPool(unsigned n_threads = 0);
+
+    // Calls task(i) for every i in [0, n_tasks) and returns once all are done. Tasks are dealt out in index order,
+    // so listing the most expensive ones first balances best. The first exception thrown by a task is rethrown here.
+    void run(std::size_t n_tasks, const std::function<void(std::size_t)> &task);
+
+    unsigned threads() const { return n_threads; }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    unsigned n_threads;
+
+    static bool take(WorkerQueue &queue, bool from_back, std::size_t &task);
+};
+
+struct ChannelSummary {
+    ChannelDataType min = 0;
+    ChannelDataType max = 0;
+    double sum = 0;
+    double sum_squares = 0;
+    std::uint64_t frames = 0;
+    std::uint64_t changes = 0;      // frames whose value differs from the previous one
+
+    void add(ChannelDataType value, bool changed);
+
+    void merge(const ChannelSummary &other);
+
+    double mean() const;
+
+    double stddev() const;
+};
+
+struct ChannelDiff {
+    std::uint64_t frames = 0;
+    std::uint64_t frames_different = 0;
+    ChannelDataType max_abs = 0;
+    double sum_abs = 0;
+    double first_difference_s = -1;     // replay time of the first differing frame, -1 when identical
+
+    void add(ChannelDataType baseline, ChannelDataType candidate, double at_s);
+
+    void merge(const ChannelDiff &other, double offset_s);
+
+    double meanAbs() const { return frames ? sum_abs / frames : 0; }
+};
+
+struct ReplayReport {
+    std::string name;
+    std::uint64_t frames = 0;
+    double replayed_s = 0;
+    double wall_s = 0;                  // thread time spent on this report, summed over logs for merged reports
+    std::vector<ChannelSummary> baseline;
+    std::vector<ChannelSummary> candidate;
+    std::vector<ChannelDiff> diff;
+
+    double speedup() const { return wall_s > 0 ? replayed_s / wall_s : 0; }
+};
+
+struct ReplayOptions {
+    int n_channels = 16;
+    double cycle_hz = 50;
+    unsigned threads = 0;               // 0 uses every hardware thread
+};
+
+// Applies a mapping (the add* calls of a configuration) to a fresh Inputs. Called concurrently from the pool threads.
+using Mapping = std::function<void(Inputs&)>;
+
+// Replays every log through two Inputs built with DeviceOpening::none, one per mapping, cycling both in lockstep
+// on the log's own clock. Nothing waits for real time and no SDL state is shared, so logs run in parallel.
+class ReplayEngine {
+public:
+    explicit ReplayEngine(ReplayOptions options = {}) : options(options) {}
+
+    // One report per log, in the order given. Logs are loaded by the worker that replays them.
+    std::vector<ReplayReport> compare(const std::vector<std::string> &log_paths, const Mapping &baseline, const Mapping &candidate) const;
+
+    // Replays a single log on the calling thread
+    ReplayReport replay(const EventLog &log, const Mapping &baseline, const Mapping &candidate, std::string name = {}) const;
+
+    // Totals over several reports, as if the logs were replayed back to back
+    static ReplayReport merge(const std::vector<ReplayReport> &reports, std::string name = "total");
+
+    static void print(std::ostream &out, const ReplayReport &report);
+
+private:
+    ReplayOptions options;
+};
+
+#endif //REPLAYENGINE_H
@@ -0,0 +1,71 @@
+//
+// Publishing immutable snapshots from one thread to another without locks
+//
+
+#ifndef SNAPSHOTPUBLISHER_H
+#define SNAPSHOTPUBLISHER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Read-copy-update for one writer and one reader. The writer builds a new T and publishes it with a single pointer
+// swap, the reader picks up the latest one whenever it calls acquire() and keeps using it until its next acquire().
+// A replaced snapshot is freed by a later publish() once the reader no longer holds it (a single hazard pointer),
+// so neither side ever waits for the other.
+template<typename T>
+class SnapshotPublisher {
+public:
+    explicit SnapshotPublisher(std::unique_ptr<T> initial) : current(initial.release()) {}
+
+    ~SnapshotPublisher() {
+        delete current.load();
+        for (T *snapshot : retired) {
+            delete snapshot;
+        }
+    }
+
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher &operator=(const SnapshotPublisher&) = delete;
+
+    // Writer side
+    void publish(std::unique_ptr<T> next) {
+        retired.push_back(current.exchange(next.release()));
+        reclaim();
+    }
+
+    // Replaced snapshots not freed yet, at most the one the reader still holds once reclaim() ran
+    std::size_t pending() const { return retired.size(); }
+
+    void reclaim() {
+        const T *in_use = hazard.load();
+        std::erase_if(retired, [in_use](T *snapshot) {
+            if (snapshot == in_use) {
+                return false;
+            }
+            delete snapshot;
+            return true;
+        });
+    }
+
+    // Reader side. The hazard is announced before the pointer is checked again, so a snapshot the writer has already
+    // replaced is never used and one the reader announced is never freed.
+    const T *acquire() {
+        T *snapshot = current.load();
+        while (true) {
+            hazard.store(snapshot);
+            T *latest = current.load();
+            if (latest == snapshot) {
+                return snapshot;
+            }
+            snapshot = latest;
+        }
+    }
+
+private:
+    std::atomic<T*> current;
+    std::atomic<const T*> hazard{nullptr};
+    std::vector<T*> retired;        // writer only
+};
+
+#endif //SNAPSHOTPUBLISHER_H
@@ -0,0 +1,61 @@
+//
+// Timestamps of the startup phases, for a startup time breakdown
+//
+
+#ifndef STARTUPTIMELINE_H
+#define STARTUPTIMELINE_H
+
+#include "inputBackend.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct StartupPhase {
+    std::string name;
+    double at_ms;           // since the first mark
+    double took_ms;         // since the previous mark
+};
+
+// Marks are set from one thread, in order
+class StartupTimeline {
+public:
+    void mark(std::string name, InputClock::time_point now = InputClock::now()) {
+        marks.emplace_back(std::move(name), now);
+    }
+
+    bool marked(const std::string &name) const {
+        for (const auto &[mark_name, time] : marks) {
+            if (mark_name == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<StartupPhase> phases() const {
+        std::vector<StartupPhase> result;
+        for (std::size_t i = 0; i < marks.size(); ++i) {
+            result.push_back({marks[i].first, milliseconds(marks[i].second - marks.front().second),
+                              i == 0 ? 0 : milliseconds(marks[i].second - marks[i - 1].second)});
+        }
+        return result;
+    }
+
+    void print(std::ostream &out) const {
+        out << "Startup:";
+        for (const StartupPhase &phase : phases()) {
+            out << " " << phase.name << " +" << phase.took_ms << "ms (" << phase.at_ms << "ms)";
+        }
+        out << std::endl;
+    }
+
+private:
+    std::vector<std::pair<std::string, InputClock::time_point>> marks;
+
+    static double milliseconds(InputClock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+};
+
+#endif //STARTUPTIMELINE_H
@@ -0,0 +1,96 @@
+//
+// Hierarchical timing wheel for time-based behaviors
+//
+
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include "inputBackend.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Four levels of 64 slots at a fixed resolution (1 ms by default, so up to ~4.6 h ahead).
+// Scheduling and cancelling are O(1). Advancing costs one slot visit per elapsed tick plus the timers that
+// expire or move down a level, so thousands of pending timers do not slow down a cycle.
+// Timers carry an opaque 64 bit payload handed back when they expire.
+class TimingWheel {
+public:
+    using TimerId = std::uint64_t;      // 0 is never a valid timer
+
+    static constexpr int slot_bits = 6;
+    static constexpr int n_slots = 1 << slot_bits;
+    static constexpr int n_levels = 4;
+
+    explicit TimingWheel(std::chrono::nanoseconds resolution = std::chrono::milliseconds(1), InputClock::time_point start = InputClock::now());
+
+    // Timers in the past expire on the next advance()
+    TimerId schedule(InputClock::time_point when, std::uint64_t payload);
+
+    // Returns false when the timer already expired or was cancelled
+    bool cancel(TimerId id);
+
+    // Expires every timer due at or before 'now', calling fire(payload) in expiry order.
+    // fire may schedule and cancel timers.
+    template<typename Fire>
+    void advance(InputClock::time_point now, Fire &&fire) {
+        std::uint64_t target = tickOf(now);
+        while (current_tick < target) {
+            if (n_pending == 0) {
+                current_tick = target;
+                break;
+            }
+            current_tick++;
+            cascade();
+            std::int32_t &head = heads[0][current_tick & (n_slots - 1)];
+            while (head >= 0) {
+                std::int32_t index = head;
+                unlink(index);
+                std::uint64_t payload = nodes[index].payload;
+                release(index);
+                fire(payload);
+            }
+        }
+    }
+
+    std::size_t pending() const { return n_pending; }
+
+    void clear();
+
+    // Cancels every timer and counts ticks from 'start' on, for clocks other than InputClock::now()
+    void restart(InputClock::time_point start);
+
+private:
+    struct Node {
+        std::uint64_t expiry_tick = 0;
+        std::uint64_t payload = 0;
+        std::uint32_t generation = 0;
+        std::int32_t prev = -1;
+        std::int32_t next = -1;
+        std::int8_t level = -1;         // -1 when free
+        std::uint8_t slot = 0;
+    };
+
+    std::chrono::nanoseconds resolution;
+    InputClock::time_point origin;
+    std::uint64_t current_tick = 0;
+    std::size_t n_pending = 0;
+
+    std::vector<Node> nodes;
+    std::vector<std::int32_t> free_nodes;
+    std::array<std::array<std::int32_t, n_slots>, n_levels> heads;
+
+    std::uint64_t tickOf(InputClock::time_point time) const;
+
+    void insert(std::int32_t index);
+
+    void unlink(std::int32_t index);
+
+    void release(std::int32_t index);
+
+    void cascade();
+};
+
+#endif //TIMINGWHEEL_H
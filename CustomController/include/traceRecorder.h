@@ -0,0 +1,81 @@
+//
+// Scoped trace points for a timeline of the polling loop, exported as Chrome trace JSON
+//
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include "inputBackend.h"
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Every thread records into its own ring buffer, allocated the first time it records, so a trace point costs two
+// clock reads and a few stores. The newest events per thread are kept. The export opens in
+// chrome://tracing and in the Perfetto UI.
+class TraceRecorder {
+public:
+    static bool enabled() { return recording.load(std::memory_order_relaxed); }
+
+    // Buffers hold this many events per thread, rounded up to a power of two. A thread that recorded before with
+    // another size reallocates its buffer at its next trace point, dropping what it had recorded.
+    static void start(std::size_t events_per_thread = 1 << 16);
+
+    static void stop();
+
+    // Drops what was recorded so far
+    static void clear();
+
+    // Shown as the thread's name in the timeline
+    static void nameThread(std::string name);
+
+    // Names must be string literals, only the pointer is stored
+    static void record(const char *name, InputClock::time_point start, InputClock::time_point end, std::int64_t arg = -1);
+
+    // Can run while threads keep recording, events overwritten during the export are left out
+    static void writeChromeJson(std::ostream &out);
+
+    static bool saveChromeJson(const std::string &path);
+
+private:
+    static std::atomic<bool> recording;
+};
+
+// Records the time between its construction and destruction. Disabled, it costs one well predicted branch.
+class TraceScope {
+public:
+    explicit TraceScope(const char *name, std::int64_t arg = -1) : name(TraceRecorder::enabled() ? name : nullptr), arg(arg) {
+        if (this->name) [[unlikely]] {
+            start = InputClock::now();
+        }
+    }
+
+    ~TraceScope() {
+        if (name) [[unlikely]] {
+            TraceRecorder::record(name, start, InputClock::now(), arg);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope &operator=(const TraceScope&) = delete;
+
+private:
+    const char *name;
+    std::int64_t arg;
+    InputClock::time_point start;
+};
+
+// Building with CUSTOMCONTROLLER_NO_TRACE removes the trace points entirely
+#ifdef CUSTOMCONTROLLER_NO_TRACE
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, arg) ((void)0)
+#else
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, arg) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name, arg)
+#endif
+
+#endif //TRACERECORDER_H
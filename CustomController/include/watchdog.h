@@ -0,0 +1,108 @@
+//
+// Cycle deadline and device liveness monitoring with failsafe channel output
+//
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include "behavior.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <SDL.h>
+
+class Inputs;
+
+enum class FailsafeMode {
+    hold, preset, neutral, SIZE
+};
+
+struct WatchdogConfig {
+    double overrun_tolerance = 0.5;                     // a cycle overruns when it starts more than period*tolerance late
+    int overruns_to_trip = 3;                           // consecutive overruns before entering failsafe
+    std::chrono::milliseconds device_timeout{0};        // max silence of a watched device, 0 disables (idle sticks send nothing)
+    std::chrono::milliseconds open_timeout{3000};       // how long a device still being opened holds failsafe
+    int recovery_cycles = 25;                           // consecutive healthy cycles before leaving failsafe
+};
+
+struct WatchdogCounters {
+    std::uint64_t cycles = 0;
+    std::uint64_t overruns = 0;
+    std::uint64_t failsafe_entries = 0;
+    std::uint64_t device_losses = 0;
+    std::int64_t last_jitter_us = 0;
+    std::int64_t max_jitter_us = 0;
+    bool failsafe = false;
+};
+
+class Watchdog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Watchdog(int n_channels);
+
+    void setConfig(const WatchdogConfig &config) { this->config = config; }
+
+    const WatchdogConfig &getConfig() const { return config; }
+
+    // Expected time between two cycles, 0 disables deadline monitoring
+    void setPeriod(Clock::duration period);
+
+    void setFailsafe(int channel_index, FailsafeMode mode, ChannelDataType preset=0);
+
+    // A watched device counts once it is open or being opened, ids of devices that never show up (e.g. saved in a
+    // previous session) are ignored. Losing a device that was open trips failsafe.
+    void watchDevice(SDL_JoystickID which);
+
+    // Replaces the watched devices, the ones watched already keep their state
+    void setWatchedDevices(const std::vector<SDL_JoystickID> &ids);
+
+    void unwatchDevices() { watched_devices.clear(); }
+
+    // Forgets the previous cycle time, e.g. after polling was paused
+    void restart();
+
+    // Checks the cycle that just ran and replaces the frame with failsafe values while tripped. Returns true when in failsafe.
+    bool apply(const Inputs &inputs, std::vector<ChannelDataType> &frame, Clock::time_point now = Clock::now());
+
+    bool inFailsafe() const { return failsafe.load(std::memory_order_relaxed); }
+
+    WatchdogCounters counters() const;
+
+    void resetCounters();
+
+private:
+    WatchdogConfig config;
+    Clock::duration period{0};
+
+    std::vector<FailsafeMode> failsafe_modes;
+    std::vector<ChannelDataType> failsafe_presets;
+    std::vector<ChannelDataType> neutral_frame;     // the channel biases, copied on the first apply
+    std::vector<ChannelDataType> last_good_frame;   // neutral until the first healthy cycle
+    struct WatchedDevice {
+        SDL_JoystickID which;
+        bool seen = false;                  // was open at some point
+        Clock::time_point opening_since{};  // first cycle it was found pending, reset once open
+    };
+
+    std::vector<WatchedDevice> watched_devices;
+
+    Clock::time_point previous_cycle{};
+    int consecutive_overruns = 0;
+    int healthy_cycles = 0;
+    bool devices_lost = false;
+
+    std::atomic<bool> failsafe{false};
+    std::atomic<std::uint64_t> cycles{0};
+    std::atomic<std::uint64_t> overruns{0};
+    std::atomic<std::uint64_t> failsafe_entries{0};
+    std::atomic<std::uint64_t> device_losses{0};
+    std::atomic<std::int64_t> last_jitter_us{0};
+    std::atomic<std::int64_t> max_jitter_us{0};
+
+    bool devicesHealthy(const Inputs &inputs, Clock::time_point now);
+};
+
+#endif //WATCHDOG_H
@@ -15,6 +15,8 @@ ButtonBehavior::ButtonBehavior(int channel_index, double value, Uint8 button, Ui
 
 AxisBehavior::AxisBehavior(int channel_index, double value, Uint8 button, Uint16 which, AxisAsButton as_button, double threshold, InputMode mode) : threshold(threshold), as_button(as_button), ButtonBehavior(channel_index, value, button, which, mode) {}
 
+TimedBehavior::TimedBehavior(int channel_index, double value, TimedMode timed_mode, std::chrono::milliseconds duration, std::chrono::milliseconds interval, InputMode mode) : InputBehavior(channel_index, value, mode), timed_mode(timed_mode), duration(duration), interval(interval) {}
+
 void InputBehavior::operator()(std::vector<ChannelDataType> &channels) const {
     switch (mode) {
         case InputMode::set:
@@ -34,27 +36,31 @@ void InputBehavior::operator()(std::vector<ChannelDataType> &channels) const {
     }
 }
 
-void AxisBehavior::operator()(std::vector<ChannelDataType> &channels, Sint32 value) {
+bool AxisBehavior::operator()(std::vector<ChannelDataType> &channels, Sint32 value, Sint32 previous_value) const {
     double value_scaled = value/static_cast<double>(max_value);
+    double previous_value_scaled = previous_value/static_cast<double>(max_value);
+    bool applied = false;
     switch (as_button) {
         case AxisAsButton::no:
             channels.at(channel_index) = value_scaled * this->value;
+            applied = true;
             break;
         case AxisAsButton::down:
             if ((value_scaled-threshold) > 0 and (previous_value_scaled-threshold) < 0) {
                 ButtonBehavior::operator()(channels);
+                applied = true;
             }
-            previous_value_scaled = value_scaled;
             break;
         case AxisAsButton::up:
             if ((value_scaled-threshold) < 0 and (previous_value_scaled-threshold) > 0) {
                 ButtonBehavior::operator()(channels);
+                applied = true;
             }
-            previous_value_scaled = value_scaled;
             break;
         default:
             break;
     }
+    return applied;
 }
 
 
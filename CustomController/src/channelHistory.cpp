@@ -0,0 +1,104 @@
+//
+// Lock-free per-channel history ring with min/max decimated views for scope plots
+//
+
+#include "channelHistory.h"
+
+#include <algorithm>
+#include <limits>
+
+ChannelHistory::ChannelHistory(int n_channels, std::size_t capacity)
+    : n_channels(n_channels), capacity_frames(std::max<std::size_t>((capacity + block_size - 1) / block_size, 2) * block_size), lanes(n_channels), running_min(n_channels), running_max(n_channels) {
+    for (Lane &lane : lanes) {
+        lane.samples.reset(new std::atomic<ChannelDataType>[capacity_frames]);
+        lane.block_min.reset(new std::atomic<ChannelDataType>[capacity_frames / block_size]);
+        lane.block_max.reset(new std::atomic<ChannelDataType>[capacity_frames / block_size]);
+    }
+}
+
+void ChannelHistory::push(const ChannelDataType *frame) {
+    std::uint64_t sequence = n_written.load(std::memory_order_relaxed);
+    std::size_t slot = sequence % capacity_frames;
+    std::size_t block = slot / block_size;
+    bool block_start = slot % block_size == 0;
+
+    for (int i = 0; i < n_channels; ++i) {
+        ChannelDataType value = frame[i];
+        Lane &lane = lanes[i];
+        lane.samples[slot].store(value, std::memory_order_relaxed);
+        running_min[i] = block_start ? value : std::min(running_min[i], value);
+        running_max[i] = block_start ? value : std::max(running_max[i], value);
+        lane.block_min[block].store(running_min[i], std::memory_order_relaxed);
+        lane.block_max[block].store(running_max[i], std::memory_order_relaxed);
+    }
+    n_written.store(sequence + 1, std::memory_order_release);
+}
+
+std::size_t ChannelHistory::decimate(int channel_index, std::size_t n_samples, std::size_t width, ChannelDataType *out_min, ChannelDataType *out_max) const {
+    if (channel_index < 0 || channel_index >= n_channels || width == 0) {
+        return width;
+    }
+    const Lane &lane = lanes[channel_index];
+
+    // The block the writer is filling shares its ring slots with the oldest block, keep clear of it
+    auto oldestReadable = [this](std::uint64_t end) {
+        return end + block_size > capacity_frames ? end + block_size - capacity_frames : 0;
+    };
+
+    std::uint64_t end = n_written.load(std::memory_order_acquire);
+    std::uint64_t begin = end > n_samples ? end - n_samples : 0;
+    std::uint64_t oldest = oldestReadable(end);
+
+    // With more pixels than samples a bucket still covers at least one sample
+    auto bucketBegin = [&](std::size_t pixel) {
+        return std::min(begin + (end - begin) * pixel / width, end - 1);
+    };
+    auto bucketEnd = [&](std::size_t pixel) {
+        return std::max(begin + (end - begin) * (pixel + 1) / width, bucketBegin(pixel) + 1);
+    };
+
+    if (end == begin) {
+        std::fill(out_min, out_min + width, 0);
+        std::fill(out_max, out_max + width, 0);
+        return width;
+    }
+
+    for (std::size_t pixel = 0; pixel < width; ++pixel) {
+        if (bucketBegin(pixel) < oldest) {
+            out_min[pixel] = 0;
+            out_max[pixel] = 0;
+            continue;
+        }
+        bucketRange(lane, bucketBegin(pixel), bucketEnd(pixel), out_min[pixel], out_max[pixel]);
+    }
+
+    // Anything the writer reached while we were reading is torn. The fence keeps the relaxed loads above before
+    // the reload, an acquire load alone would let them move after it.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    oldest = std::max(oldest, oldestReadable(n_written.load(std::memory_order_relaxed)));
+    std::size_t first_valid = 0;
+    while (first_valid < width && bucketBegin(first_valid) < oldest) {
+        first_valid++;
+    }
+    return first_valid;
+}
+
+void ChannelHistory::bucketRange(const Lane &lane, std::uint64_t begin, std::uint64_t end, ChannelDataType &min, ChannelDataType &max) const {
+    min = std::numeric_limits<ChannelDataType>::max();
+    max = std::numeric_limits<ChannelDataType>::lowest();
+    std::uint64_t sample = begin;
+    while (sample < end) {
+        std::size_t slot = sample % capacity_frames;
+        if (slot % block_size == 0 && sample + block_size <= end) {
+            std::size_t block = slot / block_size;
+            min = std::min(min, lane.block_min[block].load(std::memory_order_relaxed));
+            max = std::max(max, lane.block_max[block].load(std::memory_order_relaxed));
+            sample += block_size;
+        } else {
+            ChannelDataType value = lane.samples[slot].load(std::memory_order_relaxed);
+            min = std::min(min, value);
+            max = std::max(max, value);
+            sample++;
+        }
+    }
+}
@@ -0,0 +1,477 @@
+//
+// Linux evdev input backend reading /dev/input/event* through epoll
+//
+
+#ifdef __linux__
+
+#include "evdevBackend.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+    constexpr int bits_per_long = sizeof(unsigned long) * 8;
+
+    bool testBit(const unsigned long *bits, int bit) {
+        return (bits[bit / bits_per_long] >> (bit % bits_per_long)) & 1UL;
+    }
+
+    // SDL_GameControllerButton for BTN_SOUTH (0x130) ... BTN_THUMBR (0x13e), -1 where SDL has no equivalent
+    constexpr std::array<int, BTN_THUMBR - BTN_SOUTH + 1> gamepad_buttons = {
+        SDL_CONTROLLER_BUTTON_A, SDL_CONTROLLER_BUTTON_B, -1, SDL_CONTROLLER_BUTTON_X, SDL_CONTROLLER_BUTTON_Y, -1,
+        SDL_CONTROLLER_BUTTON_LEFTSHOULDER, SDL_CONTROLLER_BUTTON_RIGHTSHOULDER, -1, -1,
+        SDL_CONTROLLER_BUTTON_BACK, SDL_CONTROLLER_BUTTON_START, SDL_CONTROLLER_BUTTON_GUIDE,
+        SDL_CONTROLLER_BUTTON_LEFTSTICK, SDL_CONTROLLER_BUTTON_RIGHTSTICK
+    };
+
+    // Evdev button codes read as joystick buttons, numbered densely in this order
+    struct ButtonRange {
+        int first;
+        int last;
+    };
+    constexpr std::array<ButtonRange, 5> joystick_buttons = {{
+        {BTN_0, BTN_9}, {BTN_TRIGGER, BTN_DEAD}, {BTN_SOUTH, BTN_THUMBR}, {BTN_DPAD_UP, BTN_DPAD_RIGHT},
+        {BTN_TRIGGER_HAPPY1, BTN_TRIGGER_HAPPY40}
+    }};
+
+    // Joystick button number of an evdev code, -1 for codes outside the table or beyond what an SDL event holds
+    int joystickButtonFromEvdev(int code) {
+        int button = 0;
+        for (const ButtonRange &range : joystick_buttons) {
+            if (code >= range.first && code <= range.last) {
+                button += code - range.first;
+                return button <= SDL_MAX_UINT8 ? button : -1;
+            }
+            button += range.last - range.first + 1;
+        }
+        return -1;
+    }
+
+    int controllerAxisFromEvdev(int code) {
+        switch (code) {
+            case ABS_X: return SDL_CONTROLLER_AXIS_LEFTX;
+            case ABS_Y: return SDL_CONTROLLER_AXIS_LEFTY;
+            case ABS_RX: return SDL_CONTROLLER_AXIS_RIGHTX;
+            case ABS_RY: return SDL_CONTROLLER_AXIS_RIGHTY;
+            case ABS_Z: return SDL_CONTROLLER_AXIS_TRIGGERLEFT;
+            case ABS_RZ: return SDL_CONTROLLER_AXIS_TRIGGERRIGHT;
+            default: return -1;
+        }
+    }
+
+    InputClock::time_point kernelTime(const input_event &record) {
+        if (record.input_event_sec == 0 && record.input_event_usec == 0) {
+            return InputClock::now();   // hand-written records (pipes) may leave the time empty
+        }
+        return InputClock::time_point(std::chrono::seconds(record.input_event_sec) + std::chrono::microseconds(record.input_event_usec));
+    }
+}
+
+EvdevBackend::EvdevBackend() : epoll_fd(epoll_create1(EPOLL_CLOEXEC)) {
+    if (epoll_fd < 0) {
+        std::cerr << "evdev: epoll_create1 failed: " << std::strerror(errno) << std::endl;
+    }
+}
+
+EvdevBackend::~EvdevBackend() {
+    for (Device &device : open_devices) {
+        closeDevice(device);
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+}
+
+SDL_JoystickID EvdevBackend::openDevice(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "evdev: cannot open " << path << ": " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    return addDevice(fd, true);
+}
+
+int EvdevBackend::openJoysticks() {
+    int n_opened = 0;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator("/dev/input", error)) {
+        if (entry.path().filename().string().rfind("event", 0) != 0) {
+            continue;
+        }
+        int fd = open(entry.path().c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        unsigned long key_bits[(KEY_CNT + bits_per_long - 1) / bits_per_long] = {};
+        bool is_joystick = ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits) >= 0
+                && (testBit(key_bits, BTN_JOYSTICK) || testBit(key_bits, BTN_GAMEPAD));
+        if (is_joystick && addDevice(fd, true) >= 0) {
+            n_opened++;
+        } else if (!is_joystick) {
+            close(fd);
+        }
+    }
+    return n_opened;
+}
+
+SDL_JoystickID EvdevBackend::addDevice(int fd, bool owns_fd, SDL_JoystickID which, DeviceKind kind) {
+    if (fd < 0) {
+        return -1;
+    }
+    if (epoll_fd < 0) {
+        if (owns_fd) {
+            close(fd);
+        }
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    Device device;
+    device.fd = fd;
+    device.owns_fd = owns_fd;
+    device.which = which < 0 ? next_which++ : which;
+
+    // Kernel timestamps default to CLOCK_REALTIME, switch them to the clock steady_clock uses
+    int clock_id = CLOCK_MONOTONIC;
+    device.is_evdev = ioctl(fd, EVIOCSCLOCKID, &clock_id) == 0;
+    if (device.is_evdev) {
+        for (int code = 0; code < ABS_CNT; ++code) {
+            input_absinfo info{};
+            if (ioctl(fd, EVIOCGABS(code), &info) == 0 && info.maximum > info.minimum) {
+                device.ranges[code] = {info.minimum, info.maximum};
+            }
+        }
+
+        unsigned long key_bits[(KEY_CNT + bits_per_long - 1) / bits_per_long] = {};
+        unsigned long abs_bits[(ABS_CNT + bits_per_long - 1) / bits_per_long] = {};
+        ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits);
+        ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs_bits)), abs_bits);
+        device.gamepad = kind == DeviceKind::detect ? testBit(key_bits, BTN_GAMEPAD) : kind == DeviceKind::gamepad;
+
+        // Same numbering as SDL's Linux joystick driver: buttons from BTN_JOYSTICK up, then the codes below it,
+        // hats in pairs, then the remaining axes
+        device.button_index.assign(KEY_CNT, -1);
+        int n_buttons = 0;
+        for (int code = BTN_JOYSTICK; code < KEY_MAX; ++code) {
+            if (testBit(key_bits, code) && n_buttons <= SDL_MAX_UINT8) {
+                device.button_index[code] = n_buttons++;
+            }
+        }
+        for (int code = 0; code < BTN_JOYSTICK; ++code) {
+            if (testBit(key_bits, code) && n_buttons <= SDL_MAX_UINT8) {
+                device.button_index[code] = n_buttons++;
+            }
+        }
+        device.axis_index.fill(-1);
+        int n_hats = 0;
+        for (int code = ABS_HAT0X; code <= ABS_HAT3Y; code += 2) {
+            if (testBit(abs_bits, code) || testBit(abs_bits, code + 1)) {
+                device.axis_index[code] = device.axis_index[code + 1] = n_hats++;
+            }
+        }
+        int n_axes = 0;
+        for (int code = 0; code < ABS_MAX; ++code) {
+            if (code == ABS_HAT0X) {
+                code = ABS_HAT3Y;
+            } else if (testBit(abs_bits, code) && n_axes <= SDL_MAX_UINT8) {
+                device.axis_index[code] = n_axes++;
+            }
+        }
+    } else {
+        device.gamepad = kind != DeviceKind::joystick;
+        for (int code = 0; code < ABS_CNT; ++code) {
+            bool is_hat = code >= ABS_HAT0X && code <= ABS_HAT3Y;
+            device.axis_index[code] = is_hat ? (code - ABS_HAT0X) / 2 : code <= SDL_MAX_UINT8 ? code : -1;
+        }
+    }
+
+    epoll_event registration{};
+    registration.events = EPOLLIN;
+    registration.data.u32 = static_cast<std::uint32_t>(device.which);
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &registration) < 0) {
+        std::cerr << "evdev: cannot watch fd " << fd << ": " << std::strerror(errno) << std::endl;
+        if (owns_fd) {
+            close(fd);
+        }
+        return -1;
+    }
+    open_devices.push_back(std::move(device));
+
+    // Already open, so 'which' is the instance id rather than a device index, see backend_device_ids
+    SDL_Event event{};
+    event.type = SDL_JOYDEVICEADDED;
+    event.jdevice.which = open_devices.back().which;
+    pending.push_back({event, InputClock::now()});
+    return open_devices.back().which;
+}
+
+void EvdevBackend::removeDevice(SDL_JoystickID which) {
+    auto found = std::find_if(open_devices.begin(), open_devices.end(), [which](const Device &device) {return device.which == which;});
+    if (found == open_devices.end()) {
+        return;
+    }
+    closeDevice(*found);
+    open_devices.erase(found);
+
+    SDL_Event event{};
+    event.type = SDL_JOYDEVICEREMOVED;
+    event.jdevice.which = which;
+    pending.push_back({event, InputClock::now()});
+}
+
+std::vector<SDL_JoystickID> EvdevBackend::devices() const {
+    std::vector<SDL_JoystickID> ids;
+    for (const Device &device : open_devices) {
+        ids.push_back(device.which);
+    }
+    return ids;
+}
+
+bool EvdevBackend::pollEvent(SDL_Event &event, InputClock::time_point &timestamp) {
+    if (pending.empty() && epoll_fd >= 0 && !open_devices.empty()) {
+        std::array<epoll_event, 16> ready;
+        int n_ready = epoll_wait(epoll_fd, ready.data(), ready.size(), 0);
+        std::vector<SDL_JoystickID> lost;
+        for (int i = 0; i < n_ready; ++i) {
+            auto which = static_cast<SDL_JoystickID>(ready[i].data.u32);
+            auto found = std::find_if(open_devices.begin(), open_devices.end(), [which](const Device &device) {return device.which == which;});
+            if (found == open_devices.end()) {
+                continue;
+            }
+            if (ready[i].events & (EPOLLERR | EPOLLHUP) && !(ready[i].events & EPOLLIN)) {
+                lost.push_back(which);
+                continue;
+            }
+            readDevice(*found);
+            if (found->fd < 0) {
+                lost.push_back(which);
+            }
+        }
+        for (SDL_JoystickID which : lost) {
+            removeDevice(which);
+        }
+    }
+
+    if (pending.empty()) {
+        return false;
+    }
+    event = pending.front().event;
+    timestamp = pending.front().timestamp;
+    pending.pop_front();
+    return true;
+}
+
+void EvdevBackend::flush() {
+    SDL_Event event;
+    InputClock::time_point timestamp;
+    while (pollEvent(event, timestamp)) {}
+}
+
+void EvdevBackend::readDevice(Device &device) {
+    std::array<std::uint8_t, 64 * sizeof(input_event)> buffer;
+    while (true) {
+        ssize_t n_read = read(device.fd, buffer.data(), buffer.size());
+        if (n_read == 0 || (n_read < 0 && errno != EAGAIN && errno != EINTR)) {
+            closeDevice(device);    // unplugged (ENODEV) or the writing end of a pipe was closed
+            return;
+        }
+        if (n_read < 0) {
+            return;
+        }
+        device.partial.insert(device.partial.end(), buffer.begin(), buffer.begin() + n_read);
+        std::size_t n_records = device.partial.size() / sizeof(input_event);
+        for (std::size_t i = 0; i < n_records; ++i) {
+            input_event record;
+            std::memcpy(&record, device.partial.data() + i * sizeof(input_event), sizeof(input_event));
+            translate(device, record);
+        }
+        device.partial.erase(device.partial.begin(), device.partial.begin() + n_records * sizeof(input_event));
+    }
+}
+
+void EvdevBackend::translate(Device &device, const input_event &record) {
+    InputClock::time_point timestamp = kernelTime(record);
+
+    if (record.type == EV_SYN) {
+        if (record.code == SYN_DROPPED) {
+            // The kernel buffer overflowed, everything up to the next report is unreliable
+            dropped_reports++;
+            device.syncing = true;
+        } else if (record.code == SYN_REPORT && device.syncing) {
+            device.syncing = false;
+            resyncAxes(device, timestamp);
+        }
+        return;
+    }
+    if (device.syncing) {
+        return;
+    }
+
+    if (record.type == EV_KEY) {
+        if (record.value == 2) {
+            return;     // autorepeat
+        }
+        bool pressed = record.value != 0;
+        int button = device.button_index.empty() ? joystickButtonFromEvdev(record.code)
+                : record.code < KEY_CNT ? device.button_index[record.code] : -1;
+        if (device.gamepad && record.code >= BTN_SOUTH && record.code <= BTN_THUMBR && gamepad_buttons[record.code - BTN_SOUTH] >= 0) {
+            pushButton(device, pressed ? SDL_CONTROLLERBUTTONDOWN : SDL_CONTROLLERBUTTONUP, gamepad_buttons[record.code - BTN_SOUTH], pressed, timestamp);
+        } else if (button >= 0) {
+            pushButton(device, pressed ? SDL_JOYBUTTONDOWN : SDL_JOYBUTTONUP, static_cast<Uint8>(button), pressed, timestamp);
+        } else if (SDL_Keycode key = keycodeFromEvdev(record.code); key != SDLK_UNKNOWN) {
+            SDL_Event event{};
+            event.type = pressed ? SDL_KEYDOWN : SDL_KEYUP;
+            event.key.state = pressed ? SDL_PRESSED : SDL_RELEASED;
+            event.key.keysym.sym = key;
+            pending.push_back({event, timestamp});
+        }
+    } else if (record.type == EV_ABS && record.code < ABS_CNT) {
+        pushAxis(device, record.code, record.value, timestamp);
+    }
+}
+
+void EvdevBackend::resyncAxes(Device &device, InputClock::time_point timestamp) {
+    if (!device.is_evdev) {
+        return;
+    }
+    for (int code = 0; code < ABS_CNT; ++code) {
+        input_absinfo info{};
+        if (ioctl(device.fd, EVIOCGABS(code), &info) == 0 && info.maximum > info.minimum) {
+            pushAxis(device, code, info.value, timestamp);
+        }
+    }
+}
+
+void EvdevBackend::pushAxis(Device &device, int code, int value, InputClock::time_point timestamp) {
+    if (code >= ABS_HAT0X && code <= ABS_HAT3Y) {
+        pushHat(device, code, value, timestamp);
+        return;
+    }
+
+    int controller_axis = device.gamepad ? controllerAxisFromEvdev(code) : -1;
+    if (controller_axis < 0 && device.axis_index[code] < 0) {
+        return;
+    }
+    const AxisRange &range = device.ranges[code];
+    double normalized = (value - range.min) / static_cast<double>(range.max - range.min);  // 0 ... 1
+
+    SDL_Event event{};
+    if (controller_axis == SDL_CONTROLLER_AXIS_TRIGGERLEFT || controller_axis == SDL_CONTROLLER_AXIS_TRIGGERRIGHT) {
+        event.type = SDL_CONTROLLERAXISMOTION;
+        event.caxis.which = device.which;
+        event.caxis.axis = static_cast<Uint8>(controller_axis);
+        event.caxis.value = static_cast<Sint16>(std::clamp(normalized, 0.0, 1.0) * 32767);
+    } else if (controller_axis >= 0) {
+        event.type = SDL_CONTROLLERAXISMOTION;
+        event.caxis.which = device.which;
+        event.caxis.axis = static_cast<Uint8>(controller_axis);
+        event.caxis.value = static_cast<Sint16>(std::clamp(normalized * 65535 - 32768, -32768.0, 32767.0));
+    } else {
+        event.type = SDL_JOYAXISMOTION;
+        event.jaxis.which = device.which;
+        event.jaxis.axis = static_cast<Uint8>(device.axis_index[code]);
+        event.jaxis.value = static_cast<Sint16>(std::clamp(normalized * 65535 - 32768, -32768.0, 32767.0));
+    }
+    pending.push_back({event, timestamp});
+}
+
+void EvdevBackend::pushHat(Device &device, int code, int value, InputClock::time_point timestamp) {
+    int &previous = device.hat[code - ABS_HAT0X];
+    int direction = (value > 0) - (value < 0);
+    if (direction == previous) {
+        return;
+    }
+
+    if (device.gamepad && (code == ABS_HAT0X || code == ABS_HAT0Y)) {
+        int negative = code == ABS_HAT0X ? SDL_CONTROLLER_BUTTON_DPAD_LEFT : SDL_CONTROLLER_BUTTON_DPAD_UP;
+        int positive = code == ABS_HAT0X ? SDL_CONTROLLER_BUTTON_DPAD_RIGHT : SDL_CONTROLLER_BUTTON_DPAD_DOWN;
+        if (previous != 0) {
+            pushButton(device, SDL_CONTROLLERBUTTONUP, previous < 0 ? negative : positive, false, timestamp);
+        }
+        if (direction != 0) {
+            pushButton(device, SDL_CONTROLLERBUTTONDOWN, direction < 0 ? negative : positive, true, timestamp);
+        }
+        previous = direction;
+        return;
+    }
+    previous = direction;
+    if (device.axis_index[code] < 0) {
+        return;
+    }
+
+    int x = device.hat[(code - ABS_HAT0X) & ~1];
+    int y = device.hat[(code - ABS_HAT0X) | 1];
+    SDL_Event event{};
+    event.type = SDL_JOYHATMOTION;
+    event.jhat.which = device.which;
+    event.jhat.hat = static_cast<Uint8>(device.axis_index[code]);
+    event.jhat.value = (x < 0 ? SDL_HAT_LEFT : 0) | (x > 0 ? SDL_HAT_RIGHT : 0) | (y < 0 ? SDL_HAT_UP : 0) | (y > 0 ? SDL_HAT_DOWN : 0);
+    pending.push_back({event, timestamp});
+}
+
+void EvdevBackend::pushButton(const Device &device, Uint32 type, Uint8 button, bool pressed, InputClock::time_point timestamp) {
+    SDL_Event event{};
+    event.type = type;
+    // cbutton and jbutton share their layout
+    event.cbutton.which = device.which;
+    event.cbutton.button = button;
+    event.cbutton.state = pressed ? SDL_PRESSED : SDL_RELEASED;
+    pending.push_back({event, timestamp});
+}
+
+void EvdevBackend::closeDevice(Device &device) {
+    if (device.fd < 0) {
+        return;
+    }
+    if (epoll_fd >= 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, device.fd, nullptr);
+    }
+    if (device.owns_fd) {
+        close(device.fd);
+    }
+    device.fd = -1;
+}
+
+SDL_Keycode EvdevBackend::keycodeFromEvdev(int code) {
+    static constexpr const char top_row[] = "qwertyuiop";
+    static constexpr const char home_row[] = "asdfghjkl";
+    static constexpr const char bottom_row[] = "zxcvbnm";
+
+    if (code >= KEY_1 && code <= KEY_9) return '1' + (code - KEY_1);
+    if (code >= KEY_Q && code <= KEY_P) return top_row[code - KEY_Q];
+    if (code >= KEY_A && code <= KEY_L) return home_row[code - KEY_A];
+    if (code >= KEY_Z && code <= KEY_M) return bottom_row[code - KEY_Z];
+    switch (code) {
+        case KEY_0: return SDLK_0;
+        case KEY_ESC: return SDLK_ESCAPE;
+        case KEY_ENTER: return SDLK_RETURN;
+        case KEY_SPACE: return SDLK_SPACE;
+        case KEY_TAB: return SDLK_TAB;
+        case KEY_BACKSPACE: return SDLK_BACKSPACE;
+        case KEY_MINUS: return SDLK_MINUS;
+        case KEY_EQUAL: return SDLK_EQUALS;
+        case KEY_COMMA: return SDLK_COMMA;
+        case KEY_DOT: return SDLK_PERIOD;
+        case KEY_UP: return SDLK_UP;
+        case KEY_DOWN: return SDLK_DOWN;
+        case KEY_LEFT: return SDLK_LEFT;
+        case KEY_RIGHT: return SDLK_RIGHT;
+        case KEY_LEFTSHIFT: return SDLK_LSHIFT;
+        case KEY_RIGHTSHIFT: return SDLK_RSHIFT;
+        case KEY_LEFTCTRL: return SDLK_LCTRL;
+        case KEY_RIGHTCTRL: return SDLK_RCTRL;
+        case KEY_LEFTALT: return SDLK_LALT;
+        case KEY_RIGHTALT: return SDLK_RALT;
+        default: return SDLK_UNKNOWN;
+    }
+}
+
+#endif //__linux__
@@ -0,0 +1,67 @@
+//
+// Timestamped event logs: recording live input and replaying it through Inputs
+//
+
+#include "eventLog.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static constexpr char event_log_magic[8] = {'S', 'D', 'L', 'E', 'V', 'L', 'G', '1'};
+
+bool saveEventLog(const std::string &path, const EventLog &log) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Invalid event log path: " << path << std::endl;
+        return false;
+    }
+    std::uint64_t count = log.size();
+    file.write(event_log_magic, sizeof(event_log_magic));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(log.data()), static_cast<std::streamsize>(log.size() * sizeof(LoggedEvent)));
+    return static_cast<bool>(file);
+}
+
+bool loadEventLog(const std::string &path, EventLog &log) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(event_log_magic)];
+    std::uint64_t count = 0;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, event_log_magic, sizeof(magic)) != 0 || !file.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        std::cerr << "Invalid event log: " << path << std::endl;
+        return false;
+    }
+    log.resize(count);
+    if (!file.read(reinterpret_cast<char*>(log.data()), static_cast<std::streamsize>(count * sizeof(LoggedEvent)))) {
+        std::cerr << "Invalid event log, truncated: " << path << std::endl;
+        log.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ReplayBackend::pollEvent(SDL_Event &event, InputClock::time_point &timestamp) {
+    if (next == log.size()) {
+        return false;
+    }
+    timestamp = start + std::chrono::nanoseconds(log[next].at_ns);
+    if (timestamp > now) {
+        return false;
+    }
+    event = log[next++].event;
+    return true;
+}
+
+void ReplayBackend::flush() {
+    while (next < log.size() && start + std::chrono::nanoseconds(log[next].at_ns) <= now) {
+        ++next;
+    }
+}
+
+bool RecordingBackend::pollEvent(SDL_Event &event, InputClock::time_point &timestamp) {
+    if (!source.pollEvent(event, timestamp)) {
+        return false;
+    }
+    recorded.push_back({std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp - start).count(), event});
+    return true;
+}
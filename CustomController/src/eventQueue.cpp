@@ -0,0 +1,95 @@
+//
+// Single-producer / single-consumer event queue used by EventRouter
+//
+
+#include "eventQueue.h"
+
+#include <algorithm>
+#include <bit>
+
+EventQueue::EventQueue(std::size_t capacity) : buffer(std::bit_ceil(std::max<std::size_t>(capacity, 2))), mask(buffer.size() - 1) {}
+
+namespace {
+    // Absolute values, the newest one makes older ones of the same axis or hat redundant
+    bool isMotion(const SDL_Event &event) {
+        return event.type == SDL_JOYAXISMOTION || event.type == SDL_CONTROLLERAXISMOTION || event.type == SDL_JOYHATMOTION;
+    }
+
+    bool sameMotion(const SDL_Event &a, const SDL_Event &b) {
+        if (a.type != b.type) {
+            return false;
+        }
+        switch (a.type) {
+            case SDL_JOYAXISMOTION: return a.jaxis.which == b.jaxis.which && a.jaxis.axis == b.jaxis.axis;
+            case SDL_CONTROLLERAXISMOTION: return a.caxis.which == b.caxis.which && a.caxis.axis == b.caxis.axis;
+            case SDL_JOYHATMOTION: return a.jhat.which == b.jhat.which && a.jhat.hat == b.jhat.hat;
+            default: return false;
+        }
+    }
+
+    bool isPress(const SDL_Event &event) {
+        return event.type == SDL_KEYDOWN || event.type == SDL_JOYBUTTONDOWN || event.type == SDL_CONTROLLERBUTTONDOWN;
+    }
+}
+
+bool EventQueue::push(const SDL_Event &event, InputClock::time_point timestamp) {
+    retry();
+    Entry entry{event, timestamp};
+    if (backlog.empty() && write(entry)) {
+        return true;
+    }
+    std::uint64_t dropped_before = dropped_count.load(std::memory_order_relaxed);
+    hold(entry);
+    return dropped_count.load(std::memory_order_relaxed) == dropped_before;
+}
+
+void EventQueue::retry() {
+    while (!backlog.empty() && write(backlog.front())) {
+        backlog.pop_front();
+    }
+}
+
+bool EventQueue::write(const Entry &entry) {
+    std::size_t current_tail = tail.load(std::memory_order_relaxed);
+    if (current_tail - head.load(std::memory_order_acquire) >= buffer.size()) {
+        return false;
+    }
+    buffer[current_tail & mask] = entry;
+    tail.store(current_tail + 1, std::memory_order_release);
+    return true;
+}
+
+void EventQueue::hold(const Entry &entry) {
+    if (isMotion(entry.event)) {
+        for (Entry &held : backlog) {
+            if (sameMotion(held.event, entry.event)) {
+                held = entry;
+                dropped_count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    } else if (isPress(entry.event) && backlog.size() >= buffer.size()) {
+        dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    backlog.push_back(entry);
+}
+
+bool EventQueue::pop(SDL_Event &event, InputClock::time_point &timestamp) {
+    std::size_t current_head = head.load(std::memory_order_relaxed);
+    if (current_head == tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    event = buffer[current_head & mask].event;
+    timestamp = buffer[current_head & mask].timestamp;
+    head.store(current_head + 1, std::memory_order_release);
+    return true;
+}
+
+void EventQueue::clear() {
+    head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+std::size_t EventQueue::size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+}
@@ -0,0 +1,162 @@
+//
+// Routes the global SDL event queue to several Inputs instances
+//
+
+#include "eventRouter.h"
+#include "inputController.h"
+
+#include <algorithm>
+
+EventRouter::~EventRouter() {
+    stop();
+    std::vector<Route> detached;
+    {
+        std::lock_guard<std::mutex> lock(routes_mutex);
+        detached.swap(routes);
+    }
+    for (Route &route : detached) {
+        route.inputs->setBackend(nullptr);
+    }
+}
+
+EventQueue &EventRouter::attach(Inputs &inputs, std::size_t queue_capacity) {
+    std::lock_guard<std::mutex> lock(routes_mutex);
+    if (EventQueue *existing = queueOf(inputs)) {
+        return *existing;
+    }
+    routes.push_back({&inputs, std::make_unique<EventQueue>(queue_capacity)});
+    EventQueue &queue = *routes.back().queue;
+    inputs.setBackend(&queue);
+    return queue;
+}
+
+void EventRouter::detach(Inputs &inputs) {
+    std::unique_ptr<EventQueue> queue;
+    {
+        std::lock_guard<std::mutex> lock(routes_mutex);
+        auto route = std::find_if(routes.begin(), routes.end(), [&inputs](const Route &route) {return route.inputs == &inputs;});
+        if (route == routes.end()) {
+            return;
+        }
+        forget(route->queue.get());
+        queue = std::move(route->queue);
+        routes.erase(route);
+    }
+    // The instance may be polling on its own thread, the queue is freed once it switched away from it
+    inputs.setBackend(nullptr);
+}
+
+void EventRouter::claimDevice(Inputs &inputs, SDL_JoystickID which) {
+    std::lock_guard<std::mutex> lock(routes_mutex);
+    EventQueue *queue = queueOf(inputs);
+    if (!queue) {
+        return;
+    }
+    std::vector<EventQueue*> &owners = device_owners[which];
+    if (std::find(owners.begin(), owners.end(), queue) == owners.end()) {
+        owners.push_back(queue);
+    }
+}
+
+void EventRouter::claimKey(Inputs &inputs, SDL_Keycode key) {
+    std::lock_guard<std::mutex> lock(routes_mutex);
+    EventQueue *queue = queueOf(inputs);
+    if (!queue) {
+        return;
+    }
+    std::vector<EventQueue*> &owners = key_owners[key];
+    if (std::find(owners.begin(), owners.end(), queue) == owners.end()) {
+        owners.push_back(queue);
+    }
+}
+
+void EventRouter::release(Inputs &inputs) {
+    std::lock_guard<std::mutex> lock(routes_mutex);
+    if (EventQueue *queue = queueOf(inputs)) {
+        forget(queue);
+    }
+}
+
+std::size_t EventRouter::pump() {
+    // SDL is drained first, attaching and claiming never wait for SDL_PollEvent
+    pumped.clear();
+    SDL_Event polled;
+    while (SDL_PollEvent(&polled)) {
+        pumped.push_back({polled, InputClock::now()});
+    }
+
+    std::lock_guard<std::mutex> lock(routes_mutex);
+    // Events held back while a consumer was behind go first, even when SDL had nothing new
+    for (Route &route : routes) {
+        route.queue->retry();
+    }
+    for (const auto &[event, timestamp] : pumped) {
+        switch (event.type) {
+            case SDL_KEYDOWN:
+            case SDL_KEYUP: {
+                auto owners = key_owners.find(event.key.keysym.sym);
+                owners == key_owners.end() ? broadcast(event, timestamp) : deliver(owners->second, event, timestamp);
+                break;
+            }
+            case SDL_CONTROLLERBUTTONDOWN:
+            case SDL_CONTROLLERBUTTONUP:
+            case SDL_CONTROLLERAXISMOTION:
+            case SDL_JOYBUTTONDOWN:
+            case SDL_JOYBUTTONUP:
+            case SDL_JOYAXISMOTION:
+            case SDL_JOYHATMOTION: {
+                // 'which' sits at the same offset for every joystick and controller event
+                auto owners = device_owners.find(event.jbutton.which);
+                owners == device_owners.end() ? broadcast(event, timestamp) : deliver(owners->second, event, timestamp);
+                break;
+            }
+            default:
+                broadcast(event, timestamp);
+                break;
+        }
+    }
+    return pumped.size();
+}
+
+void EventRouter::start(double rate_hz) {
+    pump_scheduler.start(rate_hz, [this]() {pump();});
+}
+
+void EventRouter::stop() {
+    pump_scheduler.stop();
+}
+
+EventQueue *EventRouter::queueOf(const Inputs &inputs) {
+    for (Route &route : routes) {
+        if (route.inputs == &inputs) {
+            return route.queue.get();
+        }
+    }
+    return nullptr;
+}
+
+void EventRouter::broadcast(const SDL_Event &event, InputClock::time_point timestamp) {
+    if (routes.empty()) {
+        unrouted_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    for (Route &route : routes) {
+        route.queue->push(event, timestamp);
+    }
+}
+
+void EventRouter::deliver(const std::vector<EventQueue*> &owners, const SDL_Event &event, InputClock::time_point timestamp) {
+    for (EventQueue *queue : owners) {
+        queue->push(event, timestamp);
+    }
+}
+
+void EventRouter::forget(EventQueue *queue) {
+    for (auto &[which, owners] : device_owners) {
+        std::erase(owners, queue);
+    }
+    std::erase_if(device_owners, [](const auto &entry) {return entry.second.empty();});
+    for (auto &[key, owners] : key_owners) {
+        std::erase(owners, queue);
+    }
+    std::erase_if(key_owners, [](const auto &entry) {return entry.second.empty();});
+}
@@ -3,53 +3,254 @@
 //
 
 #include "inputController.h"
+#include "traceRecorder.h"
 #include <algorithm>
+#include <bit>
 #include <SDL_events.h>
 #include <fstream>
 
-Inputs::Inputs(int n_channels) : channels_raw(n_channels, 0), channel_bounds(n_channels, ChannelBoundType::clamp), channel_biases(n_channels, 992), channel_limits(n_channels, 992) {
-    for (int i = 0; i < SDL_NumJoysticks(); i++) {
-        if (SDL_IsGameController(i)) {
-            gamepad_indices.push_back(i);
-            gamepads.push_back(SDL_GameControllerOpen(i));
-        }
+Inputs::Inputs(int n_channels, DeviceOpening device_opening) : channels_raw(n_channels, 0), channel_bounds(n_channels, ChannelBoundType::clamp), channel_biases(n_channels, 992), channel_limits(n_channels, 992), published(std::make_unique<BehaviorTables>()), channels_out(n_channels, 0), pulse_timers(n_channels, 0), device_opening(device_opening), stats(n_channels) {
+    behaviors = published.acquire();
+    if (device_opening == DeviceOpening::background) {
+        device_opener = std::thread(&Inputs::openerLoop, this);
+    }
+    for (int i = 0; device_opening != DeviceOpening::none && i < SDL_NumJoysticks(); i++) {
+        deviceAdded(i);
     }
 }
 
 Inputs::~Inputs() {
+    if (device_opener.joinable()) {
+        {
+            std::lock_guard lock(opener_mutex);
+            opener_stopping = true;
+        }
+        opener_wake.notify_one();
+        device_opener.join();
+        // Opened but never taken over by a cycle
+        for (const OpenedDevice &device : opened_devices) {
+            closeDevice(device);
+        }
+    }
     for (SDL_GameController *pGamepad : gamepads) {
         SDL_GameControllerClose(pGamepad);
     }
+    for (SDL_Joystick *pJoystick : joysticks) {
+        SDL_JoystickClose(pJoystick);
+    }
 }
 
 bool Inputs::cycle() {
-    for (const InputBehavior &cycle_behavior : cycle_behaviors) {
-        cycle_behavior(channels_raw);
+    InputClock::time_point now = InputClock::now();
+    return runCycle(now, now);
+}
+
+bool Inputs::cycle(InputClock::time_point now) {
+    return runCycle(now, InputClock::now());
+}
+
+void Inputs::restartTimers(InputClock::time_point start) {
+    timers.restart(start);
+    std::fill(pulse_timers.begin(), pulse_timers.end(), 0);
+    for (auto &[id, timed_state] : timed_states) {
+        timed_state.timer = 0;
     }
+    group_due.fill(InputClock::time_point{});
+}
 
-    bool is_running = processEvents();
+void Inputs::commitEdit() {
+    if (edit_depth > 0 && --edit_depth == 0) {
+        edited();
+    }
+}
 
-    std::transform(channels_raw.cbegin(), channels_raw.cend(), channel_bounds.cbegin(), channels_raw.begin(), [this](const ChannelDataType &raw, const ChannelBoundType &bound) {
-        int channel_index = &raw - &channels_raw[0];
-        switch (bound) {
-            case ChannelBoundType::free:
-                return raw;
-            case ChannelBoundType::clamp:
-                return std::clamp(raw, -channel_limits[channel_index], channel_limits[channel_index]);
-            case ChannelBoundType::modulo:
-                return raw % channel_limits[channel_index];
-            case ChannelBoundType::loop:
-                return std::div(raw + channel_limits[channel_index], channel_limits[channel_index]*2).rem - channel_limits[channel_index];
-            default:
-                return std::clamp(raw, -channel_limits[channel_index], channel_limits[channel_index]);
+void Inputs::edited() {
+    if (edit_depth > 0) {
+        return;
+    }
+    std::uint64_t applied = applied_reset.load(std::memory_order_acquire);
+    std::erase_if(editing.resets, [applied](const ChannelReset &reset) {return reset.sequence <= applied;});
+    published.publish(std::make_unique<BehaviorTables>(editing));
+}
+
+void Inputs::resetChannel(int channel_index, double value) {
+    editing.resets.push_back({next_reset++, channel_index, value});
+}
+
+void Inputs::adoptBehaviors() {
+    const BehaviorTables *latest = published.acquire();
+    if (latest == behaviors) {
+        return;
+    }
+    behaviors = latest;
+
+    std::uint64_t applied = applied_reset.load(std::memory_order_relaxed);
+    for (const ChannelReset &reset : behaviors->resets) {
+        if (reset.sequence <= applied) {
+            continue;
+        }
+        applied = reset.sequence;
+        if (reset.channel_index == all_channels) {
+            timers.clear();
+            std::fill(pulse_timers.begin(), pulse_timers.end(), 0);
+            timed_states.clear();
+            press_layers.clear();
+            held_modifiers = 0;
+            continue;
         }
+        timers.cancel(pulse_timers[reset.channel_index]);
+        pulse_timers[reset.channel_index] = 0;
+        channels_raw[reset.channel_index] = reset.value;
+    }
+    applied_reset.store(applied, std::memory_order_release);
+
+    // Timed behaviors that were removed stop where they are
+    std::erase_if(timed_states, [this](const auto &entry) {
+        if (behaviors->timed_behaviors.contains(entry.first)) {
+            return false;
+        }
+        timers.cancel(entry.second.timer);
+        return true;
     });
+}
+
+bool Inputs::runCycle(InputClock::time_point cycle_start, InputClock::time_point started) {
+    TRACE_SCOPE("cycle");
+    if (devices_opened.load(std::memory_order_acquire)) {
+        adoptOpenedDevices();
+    }
+
+    adoptBehaviors();
 
+    event_time = cycle_start;
+    {
+        TRACE_SCOPE("timers");
+        timers.advance(cycle_start, [this](std::uint64_t payload) {timerExpired(payload);});
+    }
+
+    {
+        TRACE_SCOPE("cycle behaviors");
+        for (const InputBehavior &cycle_behavior : behaviors->cycle_behaviors) {
+            cycle_behavior(channels_raw);
+        }
+        stats.countBehaviors(behaviors->cycle_behaviors.size());
+    }
+
+    bool is_running = processEvents();
+
+    {
+        TRACE_SCOPE("bounds");
+        std::uint64_t used = behaviors->used_groups;
+        fresh_groups = behaviors->rated_groups & used ? dueGroups(cycle_start) & used : all_groups;
+        // Bounded every cycle, so increments and wraps don't depend on the group rate. Only the copy out is gated.
+        for (std::size_t ch = 0; ch < channels_raw.size(); ++ch) {
+            channels_raw[ch] = boundChannel(static_cast<int>(ch), channels_raw[ch]);
+        }
+        if ((fresh_groups & used) == used) {
+            channels_out = channels_raw;
+        } else if (fresh_groups) {
+            const std::vector<Uint8> &groups = behaviors->channel_groups;
+            for (std::size_t ch = 0; ch < channels_raw.size(); ++ch) {
+                if (fresh_groups >> (ch < groups.size() ? groups[ch] : 0) & 1) {
+                    channels_out[ch] = channels_raw[ch];
+                }
+            }
+        }
+    }
+
+    if (history) {
+        TRACE_SCOPE("output frame");
+        output_frame.resize(channels_raw.size());
+        getChannels(output_frame);
+        history->push(output_frame);
+    }
+
+    stats.countCycle(InputClock::now() - started);
     return is_running;
 }
 
+std::uint64_t Inputs::dueGroups(InputClock::time_point now) {
+    std::uint64_t due = ~behaviors->rated_groups;
+    for (std::uint64_t rated = behaviors->rated_groups & behaviors->used_groups; rated; rated &= rated - 1) {
+        int group = std::countr_zero(rated);
+        if (now < group_due[group]) {
+            continue;
+        }
+        due |= 1ull << group;
+        // Late updates are not caught up, a group never updates twice in a row
+        auto period = std::chrono::duration_cast<InputClock::duration>(std::chrono::duration<double>(1 / behaviors->group_rates[group]));
+        group_due[group] += period;
+        if (group_due[group] <= now) {
+            group_due[group] = now + period;
+        }
+    }
+    return due;
+}
+
+ChannelDataType Inputs::boundChannel(int channel_index, ChannelDataType raw) {
+    ChannelDataType bounded;
+    switch (channel_bounds[channel_index]) {
+        case ChannelBoundType::free:
+            return raw;
+        case ChannelBoundType::clamp:
+            bounded = std::clamp(raw, -channel_limits[channel_index], channel_limits[channel_index]);
+            break;
+        case ChannelBoundType::modulo:
+            bounded = raw % channel_limits[channel_index];
+            break;
+        case ChannelBoundType::loop:
+            bounded = std::div(raw + channel_limits[channel_index], channel_limits[channel_index]*2).rem - channel_limits[channel_index];
+            break;
+        default:
+            bounded = std::clamp(raw, -channel_limits[channel_index], channel_limits[channel_index]);
+            break;
+    }
+    if (bounded != raw) {
+        ChannelBoundType bound = channel_bounds[channel_index];
+        bound == ChannelBoundType::modulo || bound == ChannelBoundType::loop ? stats.countWrap(channel_index) : stats.countClamp(channel_index);
+    }
+    return bounded;
+}
+
+void Inputs::setChannelGroup(int channel_index, int group) {
+    if (channel_index < 0 || channel_index >= static_cast<int>(channels_raw.size())) {
+        std::cerr << "Invalid channel index: " << channel_index << std::endl;
+        return;
+    }
+    if (group < 0 || group >= max_update_groups) {
+        std::cerr << "Invalid update group: " << group << std::endl;
+        return;
+    }
+    editing.channel_groups.resize(channels_raw.size(), 0);
+    editing.channel_groups[channel_index] = static_cast<Uint8>(group);
+    editing.used_groups = 0;
+    for (Uint8 channel_group : editing.channel_groups) {
+        editing.used_groups |= 1ull << channel_group;
+    }
+    edited();
+}
+
+void Inputs::setGroupRate(int group, double rate_hz) {
+    if (group < 0 || group >= max_update_groups || !(rate_hz >= 0)) {
+        std::cerr << "Invalid update group rate: " << group << " at " << rate_hz << " Hz" << std::endl;
+        return;
+    }
+    editing.group_rates[group] = rate_hz;
+    editing.rated_groups = rate_hz > 0 ? editing.rated_groups | 1ull << group : editing.rated_groups & ~(1ull << group);
+    edited();
+}
+
+int Inputs::channelGroup(int channel_index) const {
+    return channel_index >= 0 && channel_index < static_cast<int>(editing.channel_groups.size()) ? editing.channel_groups[channel_index] : 0;
+}
+
+double Inputs::groupRate(int group) const {
+    return group >= 0 && group < max_update_groups ? editing.group_rates[group] : 0;
+}
+
 bool Inputs::cycle(std::vector<ChannelDataType> &channel_buffer) {
     bool is_running = cycle();
+    TRACE_SCOPE("getChannels");
     getChannels(channel_buffer);
     return is_running;
 }
@@ -61,75 +262,583 @@ std::vector<ChannelDataType> Inputs::getChannels() const {
 }
 
 void Inputs::getChannels(std::vector<ChannelDataType> &channel_buffer) const {
-    std::transform(channels_raw.cbegin(), channels_raw.cend(), channel_biases.cbegin(), channel_buffer.begin(), [](const ChannelDataType &raw, const ChannelDataType &bias) {
+    std::transform(channels_out.cbegin(), channels_out.cend(), channel_biases.cbegin(), channel_buffer.begin(), [](const ChannelDataType &raw, const ChannelDataType &bias) {
         return raw + bias;
     });
 }
 
+void Inputs::setBackend(InputBackend *backend) {
+    InputBackend *next = backend ? backend : &sdl_backend;
+    InputBackend *previous = this->backend.exchange(next);
+    if (previous == next) {
+        return;
+    }
+    // A drain that started on the previous backend finishes on it, the next one sees the new backend
+    while (backend_in_use.load() == previous) {
+        std::this_thread::yield();
+    }
+}
+
+InputBackend *Inputs::acquireBackend() {
+    InputBackend *current = backend.load();
+    while (true) {
+        backend_in_use.store(current);
+        InputBackend *latest = backend.load();
+        if (latest == current) {
+            return current;
+        }
+        current = latest;
+    }
+}
+
+bool Inputs::pollEvent(SDL_Event &event) {
+    InputClock::time_point timestamp;
+    bool polled = acquireBackend()->pollEvent(event, timestamp);
+    releaseBackend();
+    return polled;
+}
+
+void Inputs::flushEvents() {
+    acquireBackend()->flush();
+    releaseBackend();
+}
+
 bool Inputs::processEvents() {
+    TRACE_SCOPE("event drain");
     SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-            case SDL_QUIT:
-                return false;
-            case SDL_KEYDOWN:
-                keyDown(event.key.keysym.sym);
+    InputClock::time_point timestamp;
+    InputBackend *source = acquireBackend();
+    bool is_running = true;
+    while (is_running && source->pollEvent(event, timestamp)) {
+        TRACE_SCOPE_ARG("dispatch", event.type);
+        is_running = dispatchEvent(event, timestamp);
+    }
+    releaseBackend();
+    return is_running;
+}
+
+bool Inputs::dispatchEvent(const SDL_Event &event, InputClock::time_point timestamp) {
+    event_time = timestamp;
+    switch (event.type) {
+        case SDL_QUIT:
+            stats.countEvent(StatEvent::quit);
+            return false;
+        case SDL_KEYDOWN:
+            stats.countEvent(StatEvent::key_down);
+            countTriggered(keyDown(event.key.keysym.sym));
+            break;
+        case SDL_KEYUP:
+            stats.countEvent(StatEvent::key_up);
+            countTriggered(keyUp(event.key.keysym.sym));
+            break;
+        case SDL_CONTROLLERBUTTONDOWN:
+            stats.countEvent(StatEvent::controller_button_down);
+            device_last_input[event.cbutton.which] = timestamp;
+            countTriggered(buttonDown(InputSource::controller, event.cbutton.button, event.cbutton.which));
+            break;
+        case SDL_CONTROLLERBUTTONUP:
+            stats.countEvent(StatEvent::controller_button_up);
+            device_last_input[event.cbutton.which] = timestamp;
+            countTriggered(buttonUp(InputSource::controller, event.cbutton.button, event.cbutton.which));
+            break;
+        case SDL_CONTROLLERAXISMOTION:
+            stats.countEvent(StatEvent::controller_axis);
+            device_last_input[event.caxis.which] = timestamp;
+            countTriggered(axisMotion(InputSource::controller, event.caxis.axis, event.caxis.value, event.caxis.which));
+            break;
+        case SDL_JOYBUTTONDOWN:
+            stats.countEvent(StatEvent::joystick);
+            device_last_input[event.jbutton.which] = timestamp;
+            countTriggered(buttonDown(InputSource::joystick, event.jbutton.button, event.jbutton.which));
+            break;
+        case SDL_JOYBUTTONUP:
+            stats.countEvent(StatEvent::joystick);
+            device_last_input[event.jbutton.which] = timestamp;
+            countTriggered(buttonUp(InputSource::joystick, event.jbutton.button, event.jbutton.which));
+            break;
+        case SDL_JOYAXISMOTION:
+            stats.countEvent(StatEvent::joystick);
+            device_last_input[event.jaxis.which] = timestamp;
+            countTriggered(axisMotion(InputSource::joystick, event.jaxis.axis, event.jaxis.value, event.jaxis.which));
+            break;
+        case SDL_JOYHATMOTION:
+            stats.countEvent(StatEvent::joystick);
+            device_last_input[event.jhat.which] = timestamp;
+            countTriggered(hatMotion(event.jhat.hat, event.jhat.value, event.jhat.which));
+            break;
+        case SDL_JOYDEVICEADDED:
+            stats.countEvent(StatEvent::device);
+            deviceAdded(event.jdevice.which);
+            break;
+        case SDL_JOYDEVICEREMOVED:
+            stats.countEvent(StatEvent::device);
+            deviceRemoved(event.jdevice.which);
+            break;
+        default:
+            stats.countEvent(StatEvent::other);
+            stats.countIgnored();
+            break;
+    }
+    return true;
+}
+
+void Inputs::countTriggered(int n_behaviors) {
+    if (n_behaviors == 0) {
+        stats.countIgnored();
+    } else {
+        stats.countBehaviors(n_behaviors);
+    }
+}
+
+void Inputs::apply(const InputBehavior &input_behavior) {
+    input_behavior(channels_raw);
+    if (input_behavior.pulse.count() > 0) {
+        startPulse(input_behavior.channel_index, input_behavior.pulse);
+    }
+}
+
+void Inputs::startPulse(int channel_index, std::chrono::milliseconds duration) {
+    // Retriggering extends the running pulse instead of ending early
+    timers.cancel(pulse_timers[channel_index]);
+    pulse_timers[channel_index] = timers.schedule(event_time + duration, pulse_timer | static_cast<std::uint32_t>(channel_index));
+}
+
+void Inputs::timerExpired(std::uint64_t payload) {
+    std::uint32_t index = static_cast<std::uint32_t>(payload);
+    if ((payload & ~0xffffffffull) == pulse_timer) {
+        pulse_timers[index] = 0;
+        channels_raw[index] = 0;
+        return;
+    }
+
+    auto found = behaviors->timed_behaviors.find(index);
+    if (found == behaviors->timed_behaviors.end()) {
+        return;
+    }
+    const TimedBehavior &timed_behavior = found->second;
+    TimedState &timed_state = timed_states[index];
+    timed_state.timer = 0;
+    switch (timed_behavior.timed_mode) {
+        case TimedMode::repeat:
+            apply(timed_behavior);
+            timed_state.timer = timers.schedule(event_time + timed_behavior.interval, timed_timer | index);
+            break;
+        case TimedMode::long_press:
+            apply(timed_behavior);
+            break;
+        case TimedMode::sequence: {
+            if (timed_state.next_step >= timed_behavior.steps.size()) {
                 break;
-            case SDL_KEYUP:
-                keyUp(event.key.keysym.sym);
+            }
+            const TimedStep &step = timed_behavior.steps[timed_state.next_step++];
+            InputBehavior(timed_behavior.channel_index, step.value, step.mode)(channels_raw);
+            if (timed_state.next_step < timed_behavior.steps.size()) {
+                timed_state.timer = timers.schedule(timed_state.last_press + timed_behavior.steps[timed_state.next_step].delay, timed_timer | index);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    stats.countBehaviors(1);
+}
+
+int Inputs::timedPress(std::uint64_t trigger, std::uint64_t layer) {
+    auto found = behaviors->timed_press_triggers.find(trigger);
+    if (found == behaviors->timed_press_triggers.end()) {
+        return 0;
+    }
+    int n_triggered = 0;
+    for (std::uint32_t id : found->second) {
+        const TimedBehavior &timed_behavior = behaviors->timed_behaviors.at(id);
+        if (timed_behavior.modifiers != layer) {
+            continue;
+        }
+        ++n_triggered;
+        TimedState &timed_state = timed_states[id];
+        timers.cancel(timed_state.timer);
+        timed_state.timer = 0;
+        switch (timed_behavior.timed_mode) {
+            case TimedMode::repeat:
+                apply(timed_behavior);
+                timed_state.timer = timers.schedule(event_time + timed_behavior.duration, timed_timer | id);
                 break;
-            case SDL_CONTROLLERBUTTONDOWN:
-                controllerButtonDown(event.cbutton.button, event.cbutton.which);
+            case TimedMode::double_tap:
+                if (timed_state.last_press != InputClock::time_point{} && event_time - timed_state.last_press <= timed_behavior.duration) {
+                    apply(timed_behavior);
+                    timed_state.last_press = {};
+                } else {
+                    timed_state.last_press = event_time;
+                }
                 break;
-            case SDL_CONTROLLERBUTTONUP:
-                controllerButtonUp(event.cbutton.button, event.cbutton.which);
+            case TimedMode::long_press:
+                timed_state.timer = timers.schedule(event_time + timed_behavior.duration, timed_timer | id);
                 break;
-            case SDL_CONTROLLERAXISMOTION:
-                controllerAxisMotion(event.caxis.axis, event.caxis.value, event.caxis.which);
+            case TimedMode::sequence:
+                if (!timed_behavior.steps.empty()) {
+                    timed_state.last_press = event_time;
+                    timed_state.next_step = 0;
+                    timed_state.timer = timers.schedule(event_time + timed_behavior.steps.front().delay, timed_timer | id);
+                }
                 break;
             default:
                 break;
         }
     }
-    return true;
+    return n_triggered;
 }
 
-void Inputs::keyDown(const SDL_Keycode &key) {
-    for (const KeyBehavior &key_behavior : key_down_behaviors) {
-        if (key == key_behavior.key) {
-            key_behavior(channels_raw);
+int Inputs::timedRelease(std::uint64_t trigger) {
+    auto found = behaviors->timed_release_triggers.find(trigger);
+    if (found == behaviors->timed_release_triggers.end()) {
+        return 0;
+    }
+    // Repeats and long presses only run while the input is held
+    for (std::uint32_t id : found->second) {
+        auto timed_state = timed_states.find(id);
+        if (timed_state != timed_states.end()) {
+            timers.cancel(timed_state->second.timer);
+            timed_state->second.timer = 0;
         }
     }
+    return found->second.size();
+}
+
+void Inputs::addTimed(std::uint64_t trigger, TimedBehavior timed_behavior) {
+    if (timed_behavior.channel_index < 0 || timed_behavior.channel_index >= static_cast<int>(channels_raw.size())) {
+        std::cerr << "Invalid channel index: " << timed_behavior.channel_index << std::endl;
+        return;
+    }
+    timed_behavior.modifiers = binding_modifiers;
+    if (binding_modifiers) {
+        editing.layer_masks[trigger] |= binding_modifiers;
+    }
+    std::uint32_t id = next_timed_id++;
+    editing.timed_press_triggers[trigger].push_back(id);
+    if (timed_behavior.timed_mode == TimedMode::repeat || timed_behavior.timed_mode == TimedMode::long_press) {
+        editing.timed_release_triggers[trigger].push_back(id);
+    }
+    editing.timed_behaviors.emplace(id, std::move(timed_behavior));
 }
 
-void Inputs::keyUp(const SDL_Keycode &key) {
-    for (const KeyBehavior &key_behavior : key_up_behaviors) {
-        if (key == key_behavior.key) {
-            key_behavior(channels_raw);
+void Inputs::eraseTimed(int channel_index) {
+    // Their timers are cancelled by the cycle that takes over the edit
+    std::erase_if(editing.timed_behaviors, [channel_index](const auto &entry) {return entry.second.channel_index == channel_index;});
+    for (BindingTable<std::uint32_t> *table : {&editing.timed_press_triggers, &editing.timed_release_triggers}) {
+        for (auto &[trigger, ids] : *table) {
+            std::erase_if(ids, [this](std::uint32_t id) {return !editing.timed_behaviors.contains(id);});
         }
+        std::erase_if(*table, [](const auto &entry) {return entry.second.empty();});
     }
 }
 
-void Inputs::controllerButtonDown(const Uint8 &button, const SDL_JoystickID &which) {
-    for (const ButtonBehavior &button_behavior : button_down_behaviors) {
-        if (button == button_behavior.button && which == button_behavior.which) {
-            button_behavior(channels_raw);
+void Inputs::deviceAdded(int device_index) {
+    if (device_index >= backend_device_ids) {
+        device_last_input.emplace(device_index, InputClock::time_point{});  // opened by the backend already
+        return;
+    }
+    if (device_opening == DeviceOpening::none) {
+        return;
+    }
+    SDL_JoystickID which = SDL_JoystickGetDeviceInstanceID(device_index);
+    if (which < 0 || device_last_input.contains(which) || devices_opening.contains(which)) {
+        return;
+    }
+    if (device_opening == DeviceOpening::background) {
+        // Opening a device can take tens of milliseconds, cycles go on until it is ready
+        devices_opening.insert(which);
+        {
+            std::lock_guard lock(opener_mutex);
+            open_requests.push_back(which);
         }
+        opener_wake.notify_one();
+        return;
+    }
+
+    OpenedDevice device{which, device_index, nullptr, nullptr};
+    if (SDL_IsGameController(device_index)) {
+        device.gamepad = SDL_GameControllerOpen(device_index);
+    } else {
+        device.joystick = SDL_JoystickOpen(device_index);
+    }
+    adoptDevice(device);
+}
+
+void Inputs::adoptDevice(const OpenedDevice &device) {
+    device_last_input.emplace(device.which, InputClock::time_point{});
+    if (device.gamepad) {
+        gamepad_indices.push_back(device.device_index);
+        gamepads.push_back(device.gamepad);
+    } else if (device.joystick) {
+        // RC transmitters in joystick mode, HOTAS and pedals only report raw joystick events
+        joysticks.push_back(device.joystick);
     }
 }
 
-void Inputs::controllerButtonUp(const Uint8 &button, const SDL_JoystickID &which) {
-    for (const ButtonBehavior &button_behavior : button_up_behaviors) {
-        if (button == button_behavior.button && which == button_behavior.which) {
-            button_behavior(channels_raw);
+void Inputs::closeDevice(const OpenedDevice &device) {
+    if (device.gamepad) {
+        SDL_GameControllerClose(device.gamepad);
+    } else if (device.joystick) {
+        SDL_JoystickClose(device.joystick);
+    }
+}
+
+void Inputs::openerLoop() {
+    std::unique_lock lock(opener_mutex);
+    while (true) {
+        opener_wake.wait(lock, [this] {return !open_requests.empty() || opener_stopping;});
+        if (opener_stopping) {
+            return;
+        }
+        SDL_JoystickID which = open_requests.front();
+        open_requests.erase(open_requests.begin());
+        lock.unlock();
+
+        // Device indices shift when devices come and go, look the instance up again
+        OpenedDevice device{which, -1, nullptr, nullptr};
+        for (int i = 0; i < SDL_NumJoysticks(); ++i) {
+            if (SDL_JoystickGetDeviceInstanceID(i) == which) {
+                device.device_index = i;
+                if (SDL_IsGameController(i)) {
+                    device.gamepad = SDL_GameControllerOpen(i);
+                } else {
+                    device.joystick = SDL_JoystickOpen(i);
+                }
+                break;
+            }
+        }
+
+        lock.lock();
+        opened_devices.push_back(device);
+        devices_opened.store(true, std::memory_order_release);
+    }
+}
+
+void Inputs::adoptOpenedDevices() {
+    std::vector<OpenedDevice> opened;
+    {
+        std::lock_guard lock(opener_mutex);
+        opened.swap(opened_devices);
+        devices_opened.store(false, std::memory_order_relaxed);
+    }
+    for (const OpenedDevice &device : opened) {
+        if (!devices_opening.erase(device.which)) {
+            // Removed while it was being opened
+            closeDevice(device);
+            continue;
+        }
+        if (device.gamepad || device.joystick) {
+            adoptDevice(device);
         }
     }
 }
 
-void Inputs::controllerAxisMotion(const Uint8 &axis, const Sint16 &value, const SDL_JoystickID &which) {
-    for (AxisBehavior &axis_behavior : axis_behaviors) {
-        if (axis == axis_behavior.button && which == axis_behavior.which) {
-            axis_behavior(channels_raw, value);
+void Inputs::deviceRemoved(const SDL_JoystickID &which) {
+    devices_opening.erase(which);
+    device_last_input.erase(which);
+    for (std::size_t i = 0; i < gamepads.size(); ++i) {
+        if (gamepads[i] && SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(gamepads[i])) == which) {
+            SDL_GameControllerClose(gamepads[i]);
+            gamepads.erase(gamepads.begin() + i);
+            gamepad_indices.erase(gamepad_indices.begin() + i);
+            break;
         }
     }
-}
\ No newline at end of file
+    std::erase_if(joysticks, [which](SDL_Joystick *joystick) {
+        if (SDL_JoystickInstanceID(joystick) != which) {
+            return false;
+        }
+        SDL_JoystickClose(joystick);
+        return true;
+    });
+    std::erase_if(hat_states, [which](const auto &entry) {return static_cast<SDL_JoystickID>(entry.first >> 8) == which;});
+
+    // Whatever the device held is released, modifiers included
+    for (InputSource source : {InputSource::controller, InputSource::joystick, InputSource::hat}) {
+        auto pressed = pressed_buttons.find(bindingKey(source, which, 0));
+        if (pressed == pressed_buttons.end()) {
+            continue;
+        }
+        for (std::size_t button = 0; pressed->second.any() && button < pressed->second.size(); ++button) {
+            if (pressed->second.test(button)) {
+                pressed->second.reset(button);
+                trackModifier(bindingKey(source, which, static_cast<Uint8>(button)), false);
+                press_layers.erase(bindingKey(source, which, static_cast<Uint8>(button)));
+            }
+        }
+        pressed_buttons.erase(pressed);
+    }
+}
+
+template<typename Behavior>
+int Inputs::applyLayer(const std::vector<Behavior> &behaviors, std::uint64_t layer) {
+    int n_applied = 0;
+    for (const Behavior &behavior : behaviors) {
+        if (behavior.modifiers == layer) {
+            apply(behavior);
+            ++n_applied;
+        }
+    }
+    return n_applied;
+}
+
+std::uint64_t Inputs::modifierBit(std::uint64_t input) {
+    auto found = editing.modifier_bits.find(input);
+    if (found != editing.modifier_bits.end()) {
+        return std::uint64_t{1} << found->second;
+    }
+    if (editing.modifier_bits.size() == 64) {
+        std::cerr << "Invalid modifier, all 64 modifiers are in use" << std::endl;
+        return 0;
+    }
+    Uint8 bit = static_cast<Uint8>(editing.modifier_bits.size());
+    editing.modifier_bits.emplace(input, bit);
+    return std::uint64_t{1} << bit;
+}
+
+void Inputs::trackModifier(std::uint64_t input, bool pressed) {
+    auto found = behaviors->modifier_bits.find(input);
+    if (found == behaviors->modifier_bits.end()) {
+        return;
+    }
+    std::uint64_t bit = std::uint64_t{1} << found->second;
+    held_modifiers = pressed ? held_modifiers | bit : held_modifiers & ~bit;
+}
+
+std::uint64_t Inputs::pressLayer(std::uint64_t trigger) {
+    std::uint64_t layer = activeLayer(trigger);
+    if (layer) {
+        press_layers[trigger] = layer;
+    }
+    return layer;
+}
+
+std::uint64_t Inputs::releaseLayer(std::uint64_t trigger) {
+    // A release belongs to the layer of its press, whatever modifier was let go of first
+    auto found = press_layers.find(trigger);
+    if (found == press_layers.end()) {
+        return 0;
+    }
+    std::uint64_t layer = found->second;
+    press_layers.erase(found);
+    return layer;
+}
+
+void Inputs::rebuildLayers() {
+    editing.layer_masks.clear();
+    auto collect = [this](std::uint64_t trigger, const auto &behaviors) {
+        for (const auto &behavior : behaviors) {
+            if (behavior.modifiers) {
+                editing.layer_masks[trigger] |= behavior.modifiers;
+            }
+        }
+    };
+    for (const auto *table : {&editing.key_down_behaviors, &editing.key_up_behaviors}) {
+        for (const auto &[key, behaviors] : *table) {
+            collect(bindingKey(key), behaviors);
+        }
+    }
+    for (const auto *table : {&editing.button_down_behaviors, &editing.button_up_behaviors}) {
+        for (const auto &[trigger, behaviors] : *table) {
+            collect(trigger, behaviors);
+        }
+    }
+    for (const auto &[trigger, axis_behaviors] : editing.axis_behaviors) {
+        collect(trigger, axis_behaviors);
+    }
+    for (const auto &[trigger, ids] : editing.timed_press_triggers) {
+        for (std::uint32_t id : ids) {
+            if (std::uint64_t modifiers = editing.timed_behaviors.at(id).modifiers) {
+                editing.layer_masks[trigger] |= modifiers;
+            }
+        }
+    }
+}
+
+int Inputs::keyDown(const SDL_Keycode &key) {
+    std::uint64_t trigger = bindingKey(key);
+    std::uint64_t layer = pressLayer(trigger);
+    trackModifier(trigger, true);
+    int n_triggered = timedPress(trigger, layer);
+    auto found = behaviors->key_down_behaviors.find(key);
+    if (found == behaviors->key_down_behaviors.end()) {
+        return n_triggered;
+    }
+    return n_triggered + applyLayer(found->second, layer);
+}
+
+int Inputs::keyUp(const SDL_Keycode &key) {
+    std::uint64_t trigger = bindingKey(key);
+    std::uint64_t layer = releaseLayer(trigger);
+    trackModifier(trigger, false);
+    int n_triggered = timedRelease(trigger);
+    auto found = behaviors->key_up_behaviors.find(key);
+    if (found == behaviors->key_up_behaviors.end()) {
+        return n_triggered;
+    }
+    return n_triggered + applyLayer(found->second, layer);
+}
+
+int Inputs::buttonDown(InputSource source, const Uint8 &button, const SDL_JoystickID &which) {
+    std::uint64_t trigger = bindingKey(source, which, button);
+    std::uint64_t layer = pressLayer(trigger);
+    pressed_buttons[bindingKey(source, which, 0)].set(button);
+    trackModifier(trigger, true);
+    int n_triggered = timedPress(trigger, layer);
+    auto found = behaviors->button_down_behaviors.find(trigger);
+    if (found == behaviors->button_down_behaviors.end()) {
+        return n_triggered;
+    }
+    return n_triggered + applyLayer(found->second, layer);
+}
+
+int Inputs::buttonUp(InputSource source, const Uint8 &button, const SDL_JoystickID &which) {
+    std::uint64_t trigger = bindingKey(source, which, button);
+    std::uint64_t layer = releaseLayer(trigger);
+    pressed_buttons[bindingKey(source, which, 0)].reset(button);
+    trackModifier(trigger, false);
+    int n_triggered = timedRelease(trigger);
+    auto found = behaviors->button_up_behaviors.find(trigger);
+    if (found == behaviors->button_up_behaviors.end()) {
+        return n_triggered;
+    }
+    return n_triggered + applyLayer(found->second, layer);
+}
+
+int Inputs::axisMotion(InputSource source, const Uint8 &axis, const Sint16 &value, const SDL_JoystickID &which) {
+    std::uint64_t trigger = bindingKey(source, which, axis);
+    auto found = behaviors->axis_behaviors.find(trigger);
+    if (found == behaviors->axis_behaviors.end()) {
+        return 0;
+    }
+    // Axes have no press, a shoulder + stick chord follows the modifiers held at every motion
+    std::uint64_t layer = activeLayer(trigger);
+    Sint32 &previous_value = axis_values[trigger];
+    int n_triggered = 0;
+    for (const AxisBehavior &axis_behavior : found->second) {
+        if (axis_behavior.modifiers != layer) {
+            continue;
+        }
+        ++n_triggered;
+        if (axis_behavior(channels_raw, value, previous_value) && axis_behavior.pulse.count() > 0) {
+            startPulse(axis_behavior.channel_index, axis_behavior.pulse);
+        }
+    }
+    previous_value = value;
+    return n_triggered;
+}
+
+int Inputs::hatMotion(const Uint8 &hat, const Uint8 &value, const SDL_JoystickID &which) {
+    // A hat reports a direction mask, every bit that changed is a virtual button press or release
+    Uint8 &previous = hat_states[bindingKey(InputSource::hat, which, hat)];
+    Uint8 changed = previous ^ value;
+    previous = value;
+
+    int n_triggered = 0;
+    for (Uint8 direction : {SDL_HAT_UP, SDL_HAT_RIGHT, SDL_HAT_DOWN, SDL_HAT_LEFT}) {
+        if (changed & direction) {
+            n_triggered += value & direction ? buttonDown(InputSource::hat, hatButton(hat, direction), which) : buttonUp(InputSource::hat, hatButton(hat, direction), which);
+        }
+    }
+    return n_triggered;
+}
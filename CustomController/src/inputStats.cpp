@@ -0,0 +1,77 @@
+//
+// Runtime performance counters of the input engine
+//
+
+#include "inputStats.h"
+
+InputStats::InputStats(int n_channels) : n_channels(n_channels), clamps(new std::atomic<std::uint64_t>[n_channels]), wraps(new std::atomic<std::uint64_t>[n_channels]) {
+    reset();
+}
+
+void InputStats::countCycle(Clock::duration duration) {
+    std::int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    std::uint64_t n_cycles = cycles.load(std::memory_order_relaxed);
+    if (n_cycles == 0 || ns < cycle_min_ns.load(std::memory_order_relaxed)) {
+        cycle_min_ns.store(ns, std::memory_order_relaxed);
+    }
+    if (ns > cycle_max_ns.load(std::memory_order_relaxed)) {
+        cycle_max_ns.store(ns, std::memory_order_relaxed);
+    }
+    cycle_total_ns.store(cycle_total_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    cycles.store(n_cycles + 1, std::memory_order_relaxed);
+}
+
+InputStatsSnapshot InputStats::snapshot() const {
+    InputStatsSnapshot snapshot;
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        snapshot.events[i] = events[i].load(std::memory_order_relaxed);
+    }
+    snapshot.events_ignored = events_ignored.load(std::memory_order_relaxed);
+    snapshot.behaviors_evaluated = behaviors_evaluated.load(std::memory_order_relaxed);
+    snapshot.cycles = cycles.load(std::memory_order_relaxed);
+    snapshot.cycle_min_us = cycle_min_ns.load(std::memory_order_relaxed) / 1000.0;
+    snapshot.cycle_max_us = cycle_max_ns.load(std::memory_order_relaxed) / 1000.0;
+    if (snapshot.cycles > 0) {
+        snapshot.cycle_avg_us = cycle_total_ns.load(std::memory_order_relaxed) / 1000.0 / snapshot.cycles;
+    }
+    snapshot.clamps.resize(n_channels);
+    snapshot.wraps.resize(n_channels);
+    for (int i = 0; i < n_channels; ++i) {
+        snapshot.clamps[i] = clamps[i].load(std::memory_order_relaxed);
+        snapshot.wraps[i] = wraps[i].load(std::memory_order_relaxed);
+    }
+    snapshot.config_rebuilds = config_rebuilds.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void InputStats::reset() {
+    for (auto &counter : events) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    events_ignored.store(0, std::memory_order_relaxed);
+    behaviors_evaluated.store(0, std::memory_order_relaxed);
+    cycles.store(0, std::memory_order_relaxed);
+    cycle_min_ns.store(0, std::memory_order_relaxed);
+    cycle_max_ns.store(0, std::memory_order_relaxed);
+    cycle_total_ns.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < n_channels; ++i) {
+        clamps[i].store(0, std::memory_order_relaxed);
+        wraps[i].store(0, std::memory_order_relaxed);
+    }
+    config_rebuilds.store(0, std::memory_order_relaxed);
+}
+
+const char *InputStatsSnapshot::eventName(StatEvent event) {
+    switch (event) {
+        case StatEvent::quit: return "quit";
+        case StatEvent::key_down: return "keyDown";
+        case StatEvent::key_up: return "keyUp";
+        case StatEvent::controller_button_down: return "controllerButtonDown";
+        case StatEvent::controller_button_up: return "controllerButtonUp";
+        case StatEvent::controller_axis: return "controllerAxis";
+        case StatEvent::joystick: return "joystick";
+        case StatEvent::device: return "device";
+        case StatEvent::other: return "other";
+        default: return "unknown";
+    }
+}
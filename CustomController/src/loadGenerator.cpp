@@ -0,0 +1,369 @@
+//
+// Virtual joysticks and game controllers driven with generated input, for stress tests without hardware
+//
+
+#include "loadGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <sstream>
+
+namespace {
+
+constexpr std::size_t max_latency_samples = 1 << 20;   // the newest are kept
+
+// The standard layout SDL maps a virtual game controller to: left and right stick, both triggers, A to dpad right
+constexpr int gamepad_axes = 6;
+constexpr int gamepad_buttons = 15;
+
+constexpr Uint8 hat_positions[] = {
+    SDL_HAT_CENTERED, SDL_HAT_UP, SDL_HAT_UP | SDL_HAT_RIGHT, SDL_HAT_RIGHT, SDL_HAT_RIGHT | SDL_HAT_DOWN,
+    SDL_HAT_DOWN, SDL_HAT_DOWN | SDL_HAT_LEFT, SDL_HAT_LEFT, SDL_HAT_LEFT | SDL_HAT_UP
+};
+
+double percentile(std::vector<double> &samples, double fraction) {
+    if (samples.empty()) {
+        return 0;
+    }
+    auto nth = samples.begin() + static_cast<std::ptrdiff_t>(fraction * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+}
+
+bool loadScript(const std::string &path, std::vector<ScriptStep> &script) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Invalid script path: " << path << std::endl;
+        return false;
+    }
+    script.clear();
+    std::string line;
+    for (int line_number = 1; std::getline(file, line); ++line_number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        double at_ms;
+        std::string input;
+        ScriptStep step{};
+        if (!(fields >> at_ms)) {
+            continue;   // blank or comment
+        }
+        if (!(fields >> input >> step.index >> step.value)) {
+            std::cerr << "Invalid script line " << line_number << " in " << path << std::endl;
+            return false;
+        }
+        if (input == "axis") {
+            step.input = LoadInput::axis;
+        } else if (input == "button") {
+            step.input = LoadInput::button;
+        } else if (input == "hat") {
+            step.input = LoadInput::hat;
+        } else {
+            std::cerr << "Invalid script input " << input << " on line " << line_number << " in " << path << std::endl;
+            return false;
+        }
+        if (!(fields >> step.device)) {
+            step.device = -1;
+        }
+        step.at = std::chrono::microseconds(static_cast<std::int64_t>(at_ms * 1e3));
+        script.push_back(step);
+    }
+    std::stable_sort(script.begin(), script.end(), [](const ScriptStep &a, const ScriptStep &b) {return a.at < b.at;});
+    return true;
+}
+
+LoadGenerator::LoadGenerator(LoadProfile profile) : config(std::move(profile)) {
+    if (config.type == VirtualDeviceType::gamepad) {
+        config.axes = gamepad_axes;
+        config.buttons = gamepad_buttons;
+        config.hats = 0;
+    }
+    config.devices = std::max(config.devices, 0);
+    config.update_hz = std::max(config.update_hz, 1.0);
+    std::stable_sort(config.script.begin(), config.script.end(), [](const ScriptStep &a, const ScriptStep &b) {return a.at < b.at;});
+    // A script repeats one update after its last step, so it never replays two steps at the same instant
+    if (!config.script.empty()) {
+        script_length = config.script.back().at + std::chrono::microseconds(static_cast<std::int64_t>(1e6 / config.update_hz));
+    }
+}
+
+LoadGenerator::~LoadGenerator() {
+    detach();
+}
+
+bool LoadGenerator::attach() {
+    std::lock_guard lock(mutex);
+    slots.resize(config.devices);
+    for (int slot = 0; slot < config.devices; ++slot) {
+        slots[slot].random.seed(config.seed + slot);
+        if (!attachSlot(slots[slot])) {
+            std::cerr << "Invalid virtual device " << slot << ": " << SDL_GetError() << std::endl;
+            for (Device &device : slots) {
+                detachSlot(device);
+            }
+            slots.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LoadGenerator::attachSlot(Device &device) {
+    SDL_JoystickType type = config.type == VirtualDeviceType::gamepad ? SDL_JOYSTICK_TYPE_GAMECONTROLLER : SDL_JOYSTICK_TYPE_UNKNOWN;
+    int device_index = SDL_JoystickAttachVirtual(type, config.axes, config.buttons, config.hats);
+    if (device_index < 0) {
+        return false;
+    }
+    // Virtual devices only report changes while opened, this handle is shared with whoever else opens them
+    device.joystick = SDL_JoystickOpen(device_index);
+    if (!device.joystick) {
+        SDL_JoystickDetachVirtual(device_index);
+        return false;
+    }
+    device.which = SDL_JoystickInstanceID(device.joystick);
+    device.axes.assign(config.axes, InputHistory{});
+    device.buttons.assign(config.buttons, InputHistory{});
+    device.hats.assign(config.hats, InputHistory{});
+    return true;
+}
+
+void LoadGenerator::detachSlot(Device &device) {
+    if (!device.joystick) {
+        return;
+    }
+    SDL_JoystickClose(device.joystick);
+    device.joystick = nullptr;
+    // Detaching goes by device index, which shifts whenever a device comes or goes
+    for (int i = 0; i < SDL_NumJoysticks(); ++i) {
+        if (SDL_JoystickGetDeviceInstanceID(i) == device.which) {
+            SDL_JoystickDetachVirtual(i);
+            break;
+        }
+    }
+    device.which = -1;
+}
+
+void LoadGenerator::start() {
+    if (scheduler.running()) {
+        return;
+    }
+    if (slots.empty() && !attach()) {
+        return;
+    }
+    {
+        std::lock_guard lock(mutex);
+        started = InputClock::now();
+        counting_since = started;
+        script_origin = started;
+        script_next = 0;
+    }
+    scheduler.start(config.update_hz, [this]() {tick();});
+}
+
+void LoadGenerator::stop() {
+    scheduler.stop();
+}
+
+void LoadGenerator::detach() {
+    stop();
+    std::lock_guard lock(mutex);
+    for (Device &device : slots) {
+        detachSlot(device);
+    }
+    slots.clear();
+}
+
+std::vector<SDL_JoystickID> LoadGenerator::devices() const {
+    std::lock_guard lock(mutex);
+    std::vector<SDL_JoystickID> ids;
+    for (const Device &device : slots) {
+        ids.push_back(device.which);
+    }
+    return ids;
+}
+
+std::vector<LoadGenerator::InputHistory> *LoadGenerator::histories(Device &device, LoadInput input) {
+    switch (input) {
+        case LoadInput::axis:   return &device.axes;
+        case LoadInput::button: return &device.buttons;
+        case LoadInput::hat:    return &device.hats;
+        default:                return nullptr;
+    }
+}
+
+void LoadGenerator::set(Device &device, LoadInput input, int index, int value, InputClock::time_point now) {
+    std::vector<InputHistory> *inputs = histories(device, input);
+    if (!device.joystick || !inputs || index < 0 || index >= static_cast<int>(inputs->size()) || (*inputs)[index].current == value) {
+        return;
+    }
+    // Recorded before SDL gets the value, an event pumped right after must already find it
+    (*inputs)[index].push(value, now);
+    ++counters.sent[static_cast<std::size_t>(input)];
+    switch (input) {
+        case LoadInput::axis:   SDL_JoystickSetVirtualAxis(device.joystick, index, static_cast<Sint16>(value)); break;
+        case LoadInput::button: SDL_JoystickSetVirtualButton(device.joystick, index, static_cast<Uint8>(value)); break;
+        case LoadInput::hat:    SDL_JoystickSetVirtualHat(device.joystick, index, static_cast<Uint8>(value)); break;
+        default: break;
+    }
+}
+
+void LoadGenerator::generate(Device &device, int slot, double t, InputClock::time_point now) {
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int axis = 0; axis < config.axes; ++axis) {
+        // Axes and devices are phase shifted, so they never all move in lockstep
+        double phase = t * config.wave_hz + static_cast<double>(axis) / config.axes + slot * 0.137;
+        double fraction = phase - std::floor(phase);
+        double level = 0;
+        switch (config.wave) {
+            case WaveForm::sine:    level = std::sin(2 * std::numbers::pi * fraction); break;
+            case WaveForm::ramp:    level = 2 * fraction - 1; break;
+            case WaveForm::square:  level = fraction < 0.5 ? 1 : -1; break;
+            case WaveForm::random:  level = 2 * unit(device.random) - 1; break;
+            default: break;
+        }
+        set(device, LoadInput::axis, axis, static_cast<int>(std::lround(level * SDL_JOYSTICK_AXIS_MAX)), now);
+    }
+    if (config.buttons > 0 && unit(device.random) < config.button_hz / config.update_hz) {
+        int button = std::uniform_int_distribution<int>(0, config.buttons - 1)(device.random);
+        set(device, LoadInput::button, button, !device.buttons[button].current, now);
+    }
+    if (config.hats > 0 && unit(device.random) < config.hat_hz / config.update_hz) {
+        int hat = std::uniform_int_distribution<int>(0, config.hats - 1)(device.random);
+        int position = std::uniform_int_distribution<int>(1, std::size(hat_positions) - 1)(device.random);
+        // Never the current position, so every pick is a change
+        int value = hat_positions[position] == device.hats[hat].current ? static_cast<int>(SDL_HAT_CENTERED) : static_cast<int>(hat_positions[position]);
+        set(device, LoadInput::hat, hat, value, now);
+    }
+}
+
+void LoadGenerator::runScript(InputClock::time_point now) {
+    while (true) {
+        if (script_next == config.script.size()) {
+            script_origin += script_length;
+            script_next = 0;
+        }
+        const ScriptStep &step = config.script[script_next];
+        if (script_origin + step.at > now) {
+            return;
+        }
+        for (int slot = 0; slot < static_cast<int>(slots.size()); ++slot) {
+            if (step.device < 0 || step.device == slot) {
+                set(slots[slot], step.input, step.index, step.value, now);
+            }
+        }
+        ++script_next;
+    }
+}
+
+void LoadGenerator::tick() {
+    std::lock_guard lock(mutex);
+    InputClock::time_point now = InputClock::now();
+    if (config.script.empty()) {
+        double t = std::chrono::duration<double>(now - started).count();
+        for (int slot = 0; slot < static_cast<int>(slots.size()); ++slot) {
+            generate(slots[slot], slot, t, now);
+        }
+    } else {
+        runScript(now);
+    }
+
+    if (config.hotplug_hz > 0 && !slots.empty()) {
+        hotplug_credit += config.hotplug_hz / config.update_hz;
+        while (hotplug_credit >= 1) {
+            hotplug_credit -= 1;
+            int slot = static_cast<int>(hotplug_next++ % slots.size());
+            detachSlot(slots[slot]);
+            if (attachSlot(slots[slot])) {
+                ++counters.hotplugs;
+            } else {
+                std::cerr << "Invalid virtual device " << slot << " after hot-plug: " << SDL_GetError() << std::endl;
+            }
+        }
+    }
+}
+
+void LoadGenerator::observe(const SDL_Event &event, InputClock::time_point received) {
+    SDL_JoystickID which;
+    LoadInput input;
+    int index, value;
+    switch (event.type) {
+        case SDL_JOYAXISMOTION:
+            which = event.jaxis.which; input = LoadInput::axis; index = event.jaxis.axis; value = event.jaxis.value;
+            break;
+        case SDL_JOYBUTTONDOWN:
+        case SDL_JOYBUTTONUP:
+            which = event.jbutton.which; input = LoadInput::button; index = event.jbutton.button; value = event.jbutton.state;
+            break;
+        case SDL_JOYHATMOTION:
+            which = event.jhat.which; input = LoadInput::hat; index = event.jhat.hat; value = event.jhat.value;
+            break;
+        default:
+            return;
+    }
+
+    std::lock_guard lock(mutex);
+    auto device = std::find_if(slots.begin(), slots.end(), [which](const Device &slot) {return slot.which == which;});
+    if (device == slots.end()) {
+        return;
+    }
+    std::vector<InputHistory> &inputs = *histories(*device, input);
+    if (index >= static_cast<int>(inputs.size())) {
+        ++counters.unmatched;
+        return;
+    }
+    // SDL reports the value an input has when it pumps, so the newest change to that value is the one seen. Older
+    // changes not seen by then were coalesced away and never match later.
+    InputHistory &history = inputs[index];
+    std::size_t oldest = history.next > history_size ? history.next - history_size : 0;
+    for (std::size_t i = history.next; i-- > oldest; ) {
+        Sent &sent = history.sent[i % history_size];
+        if (sent.observed) {
+            break;
+        }
+        if (sent.value != value) {
+            continue;
+        }
+        for (std::size_t j = oldest; j <= i; ++j) {
+            history.sent[j % history_size].observed = true;
+        }
+        double latency_us = std::max(std::chrono::duration<double, std::micro>(received - sent.at).count(), 0.0);
+        if (latencies_us.size() < max_latency_samples) {
+            latencies_us.push_back(latency_us);
+        } else {
+            latencies_us[counters.latency_samples % max_latency_samples] = latency_us;
+        }
+        ++counters.latency_samples;
+        counters.latency_max_us = std::max(counters.latency_max_us, latency_us);
+        ++counters.received[static_cast<std::size_t>(input)];
+        return;
+    }
+    ++counters.unmatched;
+}
+
+LoadStats LoadGenerator::stats() const {
+    LoadStats result;
+    std::vector<double> samples;
+    {
+        std::lock_guard lock(mutex);
+        result = counters;
+        samples = latencies_us;
+        result.seconds = counting_since == InputClock::time_point{} ? 0 : std::chrono::duration<double>(InputClock::now() - counting_since).count();
+    }
+    result.latency_p50_us = percentile(samples, 0.5);
+    result.latency_p99_us = percentile(samples, 0.99);
+    result.rate = scheduler.stats();
+    return result;
+}
+
+void LoadGenerator::resetStats() {
+    std::lock_guard lock(mutex);
+    counters = LoadStats{};
+    latencies_us.clear();
+    if (counting_since != InputClock::time_point{}) {
+        counting_since = InputClock::now();
+    }
+}
@@ -0,0 +1,190 @@
+//
+// Fans output frames out to several consumers, each on its own thread
+//
+
+#include "outputFanout.h"
+#include "traceRecorder.h"
+
+#include <algorithm>
+#include <iostream>
+
+OutputFanout::~OutputFanout() {
+    clear();
+}
+
+int OutputFanout::addSink(Consumer consumer, SinkConfig config) {
+    if (!consumer || config.rate_divider == 0 || config.queue_depth == 0 || config.policy >= DropPolicy::SIZE) {
+        std::cerr << "Invalid output sink: " << config.name << std::endl;
+        return -1;
+    }
+    auto sink = std::make_shared<Sink>();
+    sink->config = std::move(config);
+    sink->consumer = std::move(consumer);
+
+    std::lock_guard lock(sinks_mutex);
+    sink->id = next_id++;
+    sink->worker = std::thread(&Sink::run, sink.get());
+    sink_list.push_back(std::move(sink));
+    return sink_list.back()->id;
+}
+
+bool OutputFanout::removeSink(int id) {
+    std::shared_ptr<Sink> removed;
+    {
+        std::lock_guard lock(sinks_mutex);
+        auto found = std::find_if(sink_list.begin(), sink_list.end(), [id](const auto &sink) {return sink->id == id;});
+        if (found == sink_list.end()) {
+            return false;
+        }
+        removed = std::move(*found);
+        sink_list.erase(found);
+    }
+    stopSink(*removed);
+    return true;
+}
+
+void OutputFanout::clear() {
+    std::vector<std::shared_ptr<Sink>> removed;
+    {
+        std::lock_guard lock(sinks_mutex);
+        removed.swap(sink_list);
+    }
+    for (auto &sink : removed) {
+        stopSink(*sink);
+    }
+}
+
+void OutputFanout::stopSink(Sink &sink) {
+    {
+        std::lock_guard lock(sink.queue_mutex);
+        sink.stopping = true;
+    }
+    sink.queue_filled.notify_one();
+    sink.queue_drained.notify_all();
+    if (sink.worker.joinable()) {
+        sink.worker.join();
+    }
+}
+
+void OutputFanout::publish(const std::vector<ChannelDataType> &channels, InputClock::time_point now, std::uint64_t fresh_groups) {
+    TRACE_SCOPE("fanout publish");
+    std::shared_ptr<const OutputFrame> frame;
+    std::vector<std::shared_ptr<Sink>> blocked;
+    std::unique_lock lock(sinks_mutex);
+    if (sink_list.empty()) {
+        return;
+    }
+    frame = std::make_shared<const OutputFrame>(OutputFrame{++sequence, now, channels, fresh_groups});
+
+    for (auto &sink : sink_list) {
+        if (!(sink->config.groups & fresh_groups)) {
+            continue;
+        }
+        if (sink->divider_count++ % sink->config.rate_divider != 0) {
+            continue;
+        }
+        sink->offered.fetch_add(1, std::memory_order_relaxed);
+
+        std::unique_lock queue_lock(sink->queue_mutex);
+        if (sink->queue.size() >= sink->config.queue_depth) {
+            switch (sink->config.policy) {
+                case DropPolicy::latest:
+                    sink->queue.pop_front();
+                    sink->dropped.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                case DropPolicy::block:
+                    blocked.push_back(sink);
+                    continue;
+                case DropPolicy::drop:
+                default:
+                    sink->dropped.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+            }
+        }
+        sink->queue.push_back(frame);
+        queue_lock.unlock();
+        sink->queue_filled.notify_one();
+    }
+    lock.unlock();
+
+    // Full block sinks are waited for without sinks_mutex, so stats() and adding or removing sinks never wait
+    // for a slow consumer. A sink removed meanwhile stops the wait and is kept alive by its reference.
+    for (auto &sink : blocked) {
+        std::unique_lock queue_lock(sink->queue_mutex);
+        sink->queue_drained.wait(queue_lock, [&sink] {return sink->queue.size() < sink->config.queue_depth || sink->stopping;});
+        if (sink->stopping) {
+            continue;
+        }
+        sink->queue.push_back(frame);
+        queue_lock.unlock();
+        sink->queue_filled.notify_one();
+    }
+}
+
+void OutputFanout::Sink::run() {
+    TraceRecorder::nameThread("sink " + config.name);
+    std::unique_lock queue_lock(queue_mutex);
+    while (true) {
+        queue_filled.wait(queue_lock, [this] {return !queue.empty() || stopping;});
+        if (queue.empty()) {
+            return;
+        }
+        std::shared_ptr<const OutputFrame> frame = std::move(queue.front());
+        queue.pop_front();
+        queue_lock.unlock();
+        queue_drained.notify_one();
+
+        {
+            TRACE_SCOPE_ARG("sink deliver", static_cast<std::int64_t>(frame->sequence));
+            consumer(*frame);
+        }
+
+        std::int64_t lag = std::chrono::duration_cast<std::chrono::nanoseconds>(InputClock::now() - frame->published).count();
+        lag_sum_ns.fetch_add(lag, std::memory_order_relaxed);
+        if (lag > lag_max_ns.load(std::memory_order_relaxed)) {
+            lag_max_ns.store(lag, std::memory_order_relaxed);
+        }
+        delivered.fetch_add(1, std::memory_order_relaxed);
+        queue_lock.lock();
+    }
+}
+
+std::vector<SinkStats> OutputFanout::stats() const {
+    std::lock_guard lock(sinks_mutex);
+    std::vector<SinkStats> all_stats;
+    all_stats.reserve(sink_list.size());
+    for (const auto &sink : sink_list) {
+        SinkStats sink_stats;
+        sink_stats.id = sink->id;
+        sink_stats.name = sink->config.name;
+        sink_stats.offered = sink->offered.load(std::memory_order_relaxed);
+        sink_stats.delivered = sink->delivered.load(std::memory_order_relaxed);
+        sink_stats.dropped = sink->dropped.load(std::memory_order_relaxed);
+        {
+            std::lock_guard queue_lock(sink->queue_mutex);
+            sink_stats.queued = sink->queue.size();
+        }
+        if (sink_stats.delivered > 0) {
+            sink_stats.mean_lag_us = sink->lag_sum_ns.load(std::memory_order_relaxed) / 1e3 / sink_stats.delivered;
+        }
+        sink_stats.max_lag_us = sink->lag_max_ns.load(std::memory_order_relaxed) / 1e3;
+        all_stats.push_back(std::move(sink_stats));
+    }
+    return all_stats;
+}
+
+void OutputFanout::resetStats() {
+    std::lock_guard lock(sinks_mutex);
+    for (auto &sink : sink_list) {
+        sink->offered.store(0, std::memory_order_relaxed);
+        sink->delivered.store(0, std::memory_order_relaxed);
+        sink->dropped.store(0, std::memory_order_relaxed);
+        sink->lag_sum_ns.store(0, std::memory_order_relaxed);
+        sink->lag_max_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::size_t OutputFanout::sinks() const {
+    std::lock_guard lock(sinks_mutex);
+    return sink_list.size();
+}
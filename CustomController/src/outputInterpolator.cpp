@@ -0,0 +1,131 @@
+//
+// Fixed rate output stage that interpolates between input frames
+//
+
+#include "outputInterpolator.h"
+
+#include <algorithm>
+#include <iostream>
+
+OutputInterpolator::OutputInterpolator(int n_channels) : n_channels(n_channels), origin(InputClock::now()),
+    target(n_channels, 0), from(n_channels, 0), delta(n_channels, 0), ramp_start(n_channels, 0), ramp_rate(n_channels, 0),
+    slew_rate(n_channels, 4000), output(n_channels, 0),
+    use_step(n_channels, 1), use_linear(n_channels, 0), use_slew(n_channels, 0), sink_frame(n_channels, 0) {}
+
+OutputInterpolator::~OutputInterpolator() {
+    stop();
+}
+
+void OutputInterpolator::setMode(int channel_index, InterpolationMode mode) {
+    if (channel_index < 0 || channel_index >= n_channels || mode >= InterpolationMode::SIZE) {
+        std::cerr << "Invalid interpolation channel or mode: " << channel_index << std::endl;
+        return;
+    }
+    std::lock_guard lock(state_mutex);
+    use_step[channel_index] = mode == InterpolationMode::step;
+    use_linear[channel_index] = mode == InterpolationMode::linear;
+    use_slew[channel_index] = mode == InterpolationMode::slew;
+}
+
+void OutputInterpolator::setSlewRate(int channel_index, double units_per_second) {
+    if (channel_index < 0 || channel_index >= n_channels || !(units_per_second > 0)) {
+        std::cerr << "Invalid slew rate: " << units_per_second << " for channel " << channel_index << std::endl;
+        return;
+    }
+    std::lock_guard lock(state_mutex);
+    slew_rate[channel_index] = units_per_second;
+}
+
+void OutputInterpolator::setMaxRamp(std::chrono::nanoseconds max_ramp) {
+    std::lock_guard lock(state_mutex);
+    this->max_ramp = std::max(std::chrono::duration<double>(max_ramp).count(), 1e-3);
+}
+
+void OutputInterpolator::setTarget(const std::vector<ChannelDataType> &frame, InputClock::time_point now) {
+    double t = seconds(now);
+    std::lock_guard lock(state_mutex);
+    int n = std::min(n_channels, static_cast<int>(frame.size()));
+    if (!primed) {
+        // Nothing to ramp from yet
+        for (int i = 0; i < n; ++i) {
+            target[i] = from[i] = output[i] = frame[i];
+        }
+        last_target = t;
+        primed = true;
+        return;
+    }
+    // Ramps last one input period, so a ramp ends when the next frame is due and never lags a whole idle time
+    double period = t - last_target;
+    input_period = input_period > 0 ? input_period + (period - input_period) * 0.125 : period;
+    last_target = t;
+    double duration = std::min(std::max(input_period, 1e-3), max_ramp);
+    for (int i = 0; i < n; ++i) {
+        double value = frame[i];
+        if (value == target[i]) {
+            continue;
+        }
+        // A linear ramp starts where the previous one is now, so a change mid-ramp stays continuous
+        double alpha = std::min(std::max((t - ramp_start[i]) * ramp_rate[i], 0.0), 1.0);
+        double current = use_linear[i] * (from[i] + delta[i] * alpha) + (1 - use_linear[i]) * output[i];
+
+        target[i] = value;
+        from[i] = current;
+        delta[i] = value - current;
+        ramp_start[i] = t;
+        ramp_rate[i] = 1 / duration;
+    }
+}
+
+void OutputInterpolator::jumpTo(const std::vector<ChannelDataType> &frame, InputClock::time_point now) {
+    double t = seconds(now);
+    std::lock_guard lock(state_mutex);
+    int n = std::min(n_channels, static_cast<int>(frame.size()));
+    for (int i = 0; i < n; ++i) {
+        target[i] = from[i] = output[i] = frame[i];
+        delta[i] = 0;
+    }
+    last_target = t;
+    primed = true;
+}
+
+void OutputInterpolator::sample(InputClock::time_point now, std::vector<ChannelDataType> &frame) {
+    double t = seconds(now);
+    frame.resize(n_channels);
+    std::lock_guard lock(state_mutex);
+    double dt = std::max(t - last_sample, 0.0);
+    last_sample = t;
+
+    // No branches in the loop body, the compiler vectorizes it across channels
+    const double *p_target = target.data(), *p_from = from.data(), *p_delta = delta.data();
+    const double *p_start = ramp_start.data(), *p_rate = ramp_rate.data(), *p_slew = slew_rate.data();
+    const double *p_step = use_step.data(), *p_linear = use_linear.data(), *p_slewing = use_slew.data();
+    double *p_output = output.data();
+    const int n = n_channels;
+    for (int i = 0; i < n; ++i) {
+        double alpha = std::min(std::max((t - p_start[i]) * p_rate[i], 0.0), 1.0);
+        double linear = p_from[i] + p_delta[i] * alpha;
+        double max_step = p_slew[i] * dt;
+        double slewed = p_output[i] + std::min(std::max(p_target[i] - p_output[i], -max_step), max_step);
+        p_output[i] = p_step[i] * p_target[i] + p_linear[i] * linear + p_slewing[i] * slewed;
+    }
+    ChannelDataType *p_frame = frame.data();
+    for (int i = 0; i < n; ++i) {
+        double value = p_output[i];
+        p_frame[i] = static_cast<ChannelDataType>(value + (value < 0 ? -0.5 : 0.5));
+    }
+}
+
+void OutputInterpolator::start(double rate_hz, std::function<void(const std::vector<ChannelDataType>&)> sink) {
+    stop();
+    this->sink = std::move(sink);
+    scheduler.start(rate_hz, [this] {
+        sample(InputClock::now(), sink_frame);
+        if (this->sink) {
+            this->sink(sink_frame);
+        }
+    });
+}
+
+void OutputInterpolator::stop() {
+    scheduler.stop();
+}
@@ -0,0 +1,145 @@
+//
+// Drift-free fixed rate scheduling on absolute deadlines
+//
+
+#include "rateScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <time.h>
+#endif
+
+DeadlineClock::DeadlineClock(double rate_hz) : rate_hz(rate_hz), period_ns(1e9 / rate_hz) {
+    restart();
+}
+
+void DeadlineClock::setRate(double rate_hz) {
+    if (!(rate_hz > 0)) {
+        std::cerr << "Invalid rate: " << rate_hz << std::endl;
+        return;
+    }
+    Clock::time_point pending = deadline();
+    this->rate_hz.store(rate_hz, std::memory_order_relaxed);
+    period_ns.store(1e9 / rate_hz, std::memory_order_relaxed);
+    origin = pending;
+    index = 0;
+}
+
+void DeadlineClock::restart(Clock::time_point now) {
+    origin = now;
+    index = 0;
+    window_start = now;
+    window_ticks = 0;
+    window_jitter_sum_us = 0;
+    window_jitter_max_us = 0;
+}
+
+void DeadlineClock::tick(Clock::time_point now) {
+    double jitter_us = std::chrono::duration<double, std::micro>(now - deadline()).count();
+    window_jitter_sum_us += std::abs(jitter_us);
+    window_jitter_max_us = std::max(window_jitter_max_us, std::abs(jitter_us));
+    window_ticks++;
+    ticks.fetch_add(1, std::memory_order_relaxed);
+
+    // Skip deadlines that already passed instead of firing a burst of catch-up ticks
+    index++;
+    if (deadline() <= now) {
+        auto behind = static_cast<std::uint64_t>(std::chrono::duration<double, std::nano>(now - deadline()).count() / period_ns.load(std::memory_order_relaxed)) + 1;
+        index += behind;
+        missed.fetch_add(behind, std::memory_order_relaxed);
+    }
+
+    auto window = now - window_start;
+    if (window >= std::chrono::seconds(1)) {
+        achieved_hz.store(window_ticks / std::chrono::duration<double>(window).count(), std::memory_order_relaxed);
+        mean_jitter_us.store(window_jitter_sum_us / window_ticks, std::memory_order_relaxed);
+        max_jitter_us.store(window_jitter_max_us, std::memory_order_relaxed);
+        window_start = now;
+        window_ticks = 0;
+        window_jitter_sum_us = 0;
+        window_jitter_max_us = 0;
+    }
+}
+
+RateStats DeadlineClock::stats() const {
+    RateStats stats;
+    stats.target_hz = rate_hz.load(std::memory_order_relaxed);
+    stats.achieved_hz = achieved_hz.load(std::memory_order_relaxed);
+    stats.mean_jitter_us = mean_jitter_us.load(std::memory_order_relaxed);
+    stats.max_jitter_us = max_jitter_us.load(std::memory_order_relaxed);
+    stats.ticks = ticks.load(std::memory_order_relaxed);
+    stats.missed = missed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void DeadlineClock::resetStats() {
+    achieved_hz.store(0, std::memory_order_relaxed);
+    mean_jitter_us.store(0, std::memory_order_relaxed);
+    max_jitter_us.store(0, std::memory_order_relaxed);
+    ticks.store(0, std::memory_order_relaxed);
+    missed.store(0, std::memory_order_relaxed);
+}
+
+RateScheduler::~RateScheduler() {
+    stop();
+}
+
+void RateScheduler::start(double rate_hz, std::function<void()> callback) {
+    if (!(rate_hz > 0)) {
+        std::cerr << "Invalid rate: " << rate_hz << std::endl;
+        return;
+    }
+    stop();
+    this->callback = std::move(callback);
+    requested_hz.store(0, std::memory_order_relaxed);
+    clock.setRate(rate_hz);
+    clock.restart();
+    active.store(true);
+    worker = std::thread([this]() {
+        while (active.load(std::memory_order_relaxed)) {
+            sleepUntil(clock.deadline());
+            if (!active.load(std::memory_order_relaxed)) {
+                break;
+            }
+            auto woke = DeadlineClock::Clock::now();
+            this->callback();
+            double new_rate = requested_hz.exchange(0, std::memory_order_relaxed);
+            clock.tick(woke);
+            if (new_rate > 0) {
+                clock.setRate(new_rate);
+            }
+        }
+    });
+}
+
+void RateScheduler::setRate(double rate_hz) {
+    if (!(rate_hz > 0)) {
+        std::cerr << "Invalid rate: " << rate_hz << std::endl;
+        return;
+    }
+    requested_hz.store(rate_hz, std::memory_order_relaxed);
+}
+
+void RateScheduler::stop() {
+    active.store(false);
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void RateScheduler::sleepUntil(DeadlineClock::Clock::time_point deadline) {
+#ifdef __linux__
+    // steady_clock is CLOCK_MONOTONIC on Linux, so its epoch matches clock_nanosleep's
+    auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    timespec target{};
+    target.tv_sec = static_cast<time_t>(since_epoch / 1000000000);
+    target.tv_nsec = static_cast<long>(since_epoch % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr) == EINTR) {}
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
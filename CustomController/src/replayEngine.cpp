@@ -0,0 +1,258 @@
+//
+// Offline replay of event logs through two mappings, in parallel and faster than real time
+//
+
+#include "replayEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <numeric>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(unsigned n_threads) : n_threads(n_threads ? n_threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+bool WorkStealingPool::take(WorkerQueue &queue, bool from_back, std::size_t &task) {
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    if (from_back) {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+    } else {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+    }
+    return true;
+}
+
+void WorkStealingPool::run(std::size_t n_tasks, const std::function<void(std::size_t)> &task) {
+    unsigned n_workers = static_cast<unsigned>(std::min<std::size_t>(n_threads, n_tasks));
+    if (n_workers == 0) {
+        return;
+    }
+    // Dealt back to front, so every worker starts with the most expensive of its tasks
+    std::vector<WorkerQueue> queues(n_workers);
+    for (std::size_t i = 0; i < n_tasks; ++i) {
+        queues[i % n_workers].tasks.push_front(i);
+    }
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto work = [&](unsigned self) {
+        std::size_t current;
+        while (true) {
+            bool found = take(queues[self], true, current);
+            for (unsigned offset = 1; !found && offset < n_workers; ++offset) {
+                found = take(queues[(self + offset) % n_workers], false, current);
+            }
+            // No task spawns new ones, so all queues being empty means this worker is done
+            if (!found) {
+                return;
+            }
+            try {
+                task(current);
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < n_workers; ++i) {
+        workers.emplace_back(work, i);
+    }
+    work(0);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ChannelSummary::add(ChannelDataType value, bool changed) {
+    min = frames ? std::min(min, value) : value;
+    max = frames ? std::max(max, value) : value;
+    sum += value;
+    sum_squares += static_cast<double>(value) * value;
+    changes += changed;
+    ++frames;
+}
+
+void ChannelSummary::merge(const ChannelSummary &other) {
+    if (other.frames == 0) {
+        return;
+    }
+    min = frames ? std::min(min, other.min) : other.min;
+    max = frames ? std::max(max, other.max) : other.max;
+    sum += other.sum;
+    sum_squares += other.sum_squares;
+    frames += other.frames;
+    changes += other.changes;
+}
+
+double ChannelSummary::mean() const {
+    return frames ? sum / frames : 0;
+}
+
+double ChannelSummary::stddev() const {
+    if (frames == 0) {
+        return 0;
+    }
+    double m = mean();
+    return std::sqrt(std::max(sum_squares / frames - m * m, 0.0));
+}
+
+void ChannelDiff::add(ChannelDataType baseline, ChannelDataType candidate, double at_s) {
+    ChannelDataType difference = std::abs(candidate - baseline);
+    if (difference != 0) {
+        if (frames_different == 0) {
+            first_difference_s = at_s;
+        }
+        ++frames_different;
+        max_abs = std::max(max_abs, difference);
+        sum_abs += difference;
+    }
+    ++frames;
+}
+
+void ChannelDiff::merge(const ChannelDiff &other, double offset_s) {
+    if (first_difference_s < 0 && other.first_difference_s >= 0) {
+        first_difference_s = offset_s + other.first_difference_s;
+    }
+    frames += other.frames;
+    frames_different += other.frames_different;
+    max_abs = std::max(max_abs, other.max_abs);
+    sum_abs += other.sum_abs;
+}
+
+ReplayReport ReplayEngine::replay(const EventLog &log, const Mapping &baseline, const Mapping &candidate, std::string name) const {
+    auto wall_start = InputClock::now();
+    ReplayReport report;
+    report.name = std::move(name);
+    report.baseline.resize(options.n_channels);
+    report.candidate.resize(options.n_channels);
+    report.diff.resize(options.n_channels);
+
+    Inputs baseline_inputs(options.n_channels, DeviceOpening::none);
+    Inputs candidate_inputs(options.n_channels, DeviceOpening::none);
+    baseline_inputs.beginEdit();
+    baseline(baseline_inputs);
+    baseline_inputs.commitEdit();
+    candidate_inputs.beginEdit();
+    candidate(candidate_inputs);
+    candidate_inputs.commitEdit();
+
+    // Both run on the same replay clock, so their timers expire in the same cycles
+    InputClock::time_point start = InputClock::now();
+    baseline_inputs.restartTimers(start);
+    candidate_inputs.restartTimers(start);
+    ReplayBackend baseline_events(log, start);
+    ReplayBackend candidate_events(log, start);
+    baseline_inputs.setBackend(&baseline_events);
+    candidate_inputs.setBackend(&candidate_events);
+
+    std::vector<ChannelDataType> baseline_frame(options.n_channels), candidate_frame(options.n_channels);
+    std::vector<ChannelDataType> baseline_previous(options.n_channels), candidate_previous(options.n_channels);
+    double period_ns = 1e9 / options.cycle_hz;
+    std::int64_t end_ns = log.empty() ? 0 : log.back().at_ns;
+
+    for (std::uint64_t k = 0; ; ++k) {
+        // Cycle times are computed from the index, rounding never accumulates over hours of replay
+        auto at = std::chrono::nanoseconds(static_cast<std::int64_t>(k * period_ns));
+        InputClock::time_point now = start + at;
+        baseline_events.setTime(now);
+        candidate_events.setTime(now);
+        bool running = baseline_inputs.cycle(now) & candidate_inputs.cycle(now);
+        baseline_inputs.getChannels(baseline_frame);
+        candidate_inputs.getChannels(candidate_frame);
+
+        double at_s = std::chrono::duration<double>(at).count();
+        for (int ch = 0; ch < options.n_channels; ++ch) {
+            report.baseline[ch].add(baseline_frame[ch], k > 0 && baseline_frame[ch] != baseline_previous[ch]);
+            report.candidate[ch].add(candidate_frame[ch], k > 0 && candidate_frame[ch] != candidate_previous[ch]);
+            report.diff[ch].add(baseline_frame[ch], candidate_frame[ch], at_s);
+        }
+        baseline_previous.swap(baseline_frame);
+        candidate_previous.swap(candidate_frame);
+        ++report.frames;
+        report.replayed_s = at_s;
+
+        if (!running || at.count() >= end_ns) {
+            break;
+        }
+    }
+
+    report.wall_s = std::chrono::duration<double>(InputClock::now() - wall_start).count();
+    return report;
+}
+
+std::vector<ReplayReport> ReplayEngine::compare(const std::vector<std::string> &log_paths, const Mapping &baseline, const Mapping &candidate) const {
+    // Biggest logs first, so the pool does not end up waiting on one long log started last
+    std::vector<std::size_t> order(log_paths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<std::uintmax_t> sizes(log_paths.size(), 0);
+    for (std::size_t i = 0; i < log_paths.size(); ++i) {
+        std::error_code error;
+        sizes[i] = std::filesystem::file_size(log_paths[i], error);
+    }
+    std::stable_sort(order.begin(), order.end(), [&sizes](std::size_t a, std::size_t b) {return sizes[a] > sizes[b];});
+
+    std::vector<ReplayReport> reports(log_paths.size());
+    WorkStealingPool pool(options.threads);
+    pool.run(order.size(), [&](std::size_t task) {
+        std::size_t index = order[task];
+        EventLog log;
+        if (!loadEventLog(log_paths[index], log)) {
+            reports[index].name = log_paths[index];
+            return;
+        }
+        reports[index] = replay(log, baseline, candidate, log_paths[index]);
+    });
+    return reports;
+}
+
+ReplayReport ReplayEngine::merge(const std::vector<ReplayReport> &reports, std::string name) {
+    ReplayReport total;
+    total.name = std::move(name);
+    for (const ReplayReport &report : reports) {
+        std::size_t n_channels = report.diff.size();
+        if (total.diff.size() < n_channels) {
+            total.baseline.resize(n_channels);
+            total.candidate.resize(n_channels);
+            total.diff.resize(n_channels);
+        }
+        for (std::size_t ch = 0; ch < n_channels; ++ch) {
+            total.baseline[ch].merge(report.baseline[ch]);
+            total.candidate[ch].merge(report.candidate[ch]);
+            total.diff[ch].merge(report.diff[ch], total.replayed_s);
+        }
+        total.frames += report.frames;
+        total.replayed_s += report.replayed_s;
+        total.wall_s += report.wall_s;
+    }
+    return total;
+}
+
+void ReplayEngine::print(std::ostream &out, const ReplayReport &report) {
+    out << "Replay " << report.name << ": " << report.frames << " frames, " << report.replayed_s << " s replayed in "
+        << report.wall_s << " s (" << report.speedup() << "x real time)" << std::endl;
+    out << " ch |   baseline min/max/mean/sd    |   candidate min/max/mean/sd   | changed frames | max diff | mean diff | first diff s" << std::endl;
+    for (std::size_t ch = 0; ch < report.diff.size(); ++ch) {
+        const ChannelSummary &a = report.baseline[ch];
+        const ChannelSummary &b = report.candidate[ch];
+        const ChannelDiff &d = report.diff[ch];
+        out << std::setw(3) << ch << " | "
+            << std::setw(5) << a.min << " " << std::setw(5) << a.max << " " << std::setw(8) << std::fixed << std::setprecision(1) << a.mean() << " " << std::setw(7) << a.stddev() << " | "
+            << std::setw(5) << b.min << " " << std::setw(5) << b.max << " " << std::setw(8) << b.mean() << " " << std::setw(7) << b.stddev() << " | "
+            << std::setw(14) << d.frames_different << " | " << std::setw(8) << d.max_abs << " | " << std::setw(9) << std::setprecision(2) << d.meanAbs() << " | "
+            << std::setprecision(3) << d.first_difference_s << std::defaultfloat << std::endl;
+    }
+}
@@ -0,0 +1,133 @@
+//
+// Hierarchical timing wheel for time-based behaviors
+//
+
+#include "timingWheel.h"
+
+#include <algorithm>
+
+TimingWheel::TimingWheel(std::chrono::nanoseconds resolution, InputClock::time_point start) : resolution(resolution), origin(start) {
+    clear();
+}
+
+TimingWheel::TimerId TimingWheel::schedule(InputClock::time_point when, std::uint64_t payload) {
+    std::int32_t index;
+    if (free_nodes.empty()) {
+        index = static_cast<std::int32_t>(nodes.size());
+        nodes.emplace_back();
+    } else {
+        index = free_nodes.back();
+        free_nodes.pop_back();
+    }
+    Node &node = nodes[index];
+    // The current tick was already processed, the earliest a new timer can expire is the next one
+    node.expiry_tick = std::max(tickOf(when), current_tick + 1);
+    node.payload = payload;
+    insert(index);
+    n_pending++;
+    return (static_cast<TimerId>(node.generation) << 32) | static_cast<TimerId>(index + 1);
+}
+
+bool TimingWheel::cancel(TimerId id) {
+    auto index = static_cast<std::int64_t>(id & 0xffffffff) - 1;
+    if (index < 0 || index >= static_cast<std::int64_t>(nodes.size())) {
+        return false;
+    }
+    Node &node = nodes[index];
+    if (node.level < 0 || node.generation != static_cast<std::uint32_t>(id >> 32)) {
+        return false;
+    }
+    unlink(static_cast<std::int32_t>(index));
+    release(static_cast<std::int32_t>(index));
+    return true;
+}
+
+void TimingWheel::clear() {
+    for (auto &level : heads) {
+        level.fill(-1);
+    }
+    free_nodes.clear();
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].level >= 0) {
+            nodes[i].level = -1;
+            nodes[i].generation++;
+        }
+        free_nodes.push_back(static_cast<std::int32_t>(i));
+    }
+    n_pending = 0;
+}
+
+void TimingWheel::restart(InputClock::time_point start) {
+    clear();
+    origin = start;
+    current_tick = 0;
+}
+
+std::uint64_t TimingWheel::tickOf(InputClock::time_point time) const {
+    if (time <= origin) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>((time - origin) / resolution);
+}
+
+void TimingWheel::insert(std::int32_t index) {
+    Node &node = nodes[index];
+    std::uint64_t delta = node.expiry_tick > current_tick ? node.expiry_tick - current_tick : 0;
+
+    // Timers further out than the top level are parked in it and moved down again when it cascades
+    int level = 0;
+    while (level < n_levels - 1 && delta >= (std::uint64_t{1} << (slot_bits * (level + 1)))) {
+        level++;
+    }
+    std::uint64_t placement = std::min(node.expiry_tick, current_tick + (std::uint64_t{1} << (slot_bits * n_levels)) - 1);
+    if (level == 0) {
+        placement = std::max(placement, current_tick);
+    }
+
+    node.level = static_cast<std::int8_t>(level);
+    node.slot = static_cast<std::uint8_t>((placement >> (slot_bits * level)) & (n_slots - 1));
+    node.prev = -1;
+    node.next = heads[level][node.slot];
+    if (node.next >= 0) {
+        nodes[node.next].prev = index;
+    }
+    heads[level][node.slot] = index;
+}
+
+void TimingWheel::unlink(std::int32_t index) {
+    Node &node = nodes[index];
+    if (node.prev >= 0) {
+        nodes[node.prev].next = node.next;
+    } else {
+        heads[node.level][node.slot] = node.next;
+    }
+    if (node.next >= 0) {
+        nodes[node.next].prev = node.prev;
+    }
+    node.prev = -1;
+    node.next = -1;
+}
+
+void TimingWheel::release(std::int32_t index) {
+    nodes[index].level = -1;
+    nodes[index].generation++;
+    free_nodes.push_back(index);
+    n_pending--;
+}
+
+void TimingWheel::cascade() {
+    // When a level wraps, the matching slot of the level above is due and its timers move down
+    for (int level = 1; level < n_levels; ++level) {
+        if ((current_tick & ((std::uint64_t{1} << (slot_bits * level)) - 1)) != 0) {
+            break;
+        }
+        std::int32_t &head = heads[level][(current_tick >> (slot_bits * level)) & (n_slots - 1)];
+        std::int32_t index = head;
+        head = -1;
+        while (index >= 0) {
+            std::int32_t next = nodes[index].next;
+            insert(index);
+            index = next;
+        }
+    }
+}
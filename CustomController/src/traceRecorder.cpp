@@ -0,0 +1,197 @@
+//
+// Scoped trace points for a timeline of the polling loop, exported as Chrome trace JSON
+//
+
+#include "traceRecorder.h"
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> TraceRecorder::recording{false};
+
+namespace {
+
+// Slots are written by their thread while an export may read them, every field is a relaxed atomic and the head
+// tells which slots are complete
+struct TraceSlot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<std::int64_t> start_ns{0};
+    std::atomic<std::int64_t> duration_ns{0};
+    std::atomic<std::int64_t> arg{-1};
+};
+
+struct ThreadBuffer {
+    explicit ThreadBuffer(std::size_t capacity) : slots(capacity) {}
+
+    std::vector<TraceSlot> slots;                   // power of two
+    std::atomic<std::uint64_t> head{0};             // events recorded so far, written by the owning thread only
+    std::atomic<std::size_t> resize_to{0};          // capacity start() asked for, applied by the owning thread
+    std::uint64_t cleared_at = 0;                   // guarded by registry_mutex
+    std::string name;                               // guarded by registry_mutex
+};
+
+struct TraceEventCopy {
+    const char *name;
+    std::int64_t start_ns;
+    std::int64_t duration_ns;
+    std::int64_t arg;
+};
+
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;   // kept after their thread ended, for the export
+std::size_t buffer_capacity = 1 << 16;                  // guarded by registry_mutex
+
+thread_local ThreadBuffer *thread_buffer = nullptr;
+thread_local std::string thread_name;
+
+ThreadBuffer *registerThread() {
+    std::lock_guard lock(registry_mutex);
+    registry.push_back(std::make_unique<ThreadBuffer>(buffer_capacity));
+    registry.back()->name = thread_name;
+    return registry.back().get();
+}
+
+// Only the owning thread writes its slots, so it reallocates them itself. The lock keeps exports off the old slots.
+void resizeThreadBuffer(ThreadBuffer &buffer) {
+    std::lock_guard lock(registry_mutex);
+    std::size_t capacity = buffer.resize_to.exchange(0, std::memory_order_relaxed);
+    if (capacity == 0 || capacity == buffer.slots.size()) {
+        return;
+    }
+    buffer.slots = std::vector<TraceSlot>(capacity);
+    buffer.head.store(0, std::memory_order_relaxed);
+    buffer.cleared_at = 0;
+}
+
+std::int64_t nanoseconds(InputClock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void writeJsonString(std::ostream &out, const std::string &text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+}
+
+void TraceRecorder::start(std::size_t events_per_thread) {
+    {
+        std::lock_guard lock(registry_mutex);
+        buffer_capacity = std::bit_ceil(std::max<std::size_t>(events_per_thread, 2));
+        for (const auto &buffer : registry) {
+            buffer->resize_to.store(buffer->slots.size() == buffer_capacity ? 0 : buffer_capacity, std::memory_order_relaxed);
+        }
+    }
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::stop() {
+    recording.store(false, std::memory_order_relaxed);
+}
+
+void TraceRecorder::clear() {
+    std::lock_guard lock(registry_mutex);
+    for (const auto &buffer : registry) {
+        buffer->cleared_at = buffer->head.load(std::memory_order_acquire);
+    }
+}
+
+void TraceRecorder::nameThread(std::string name) {
+    thread_name = std::move(name);
+    if (thread_buffer) {
+        std::lock_guard lock(registry_mutex);
+        thread_buffer->name = thread_name;
+    }
+}
+
+void TraceRecorder::record(const char *name, InputClock::time_point start, InputClock::time_point end, std::int64_t arg) {
+    if (!thread_buffer) [[unlikely]] {
+        thread_buffer = registerThread();
+    }
+    if (thread_buffer->resize_to.load(std::memory_order_relaxed) != 0) [[unlikely]] {
+        resizeThreadBuffer(*thread_buffer);
+    }
+    std::uint64_t head = thread_buffer->head.load(std::memory_order_relaxed);
+    TraceSlot &slot = thread_buffer->slots[head & (thread_buffer->slots.size() - 1)];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start_ns.store(nanoseconds(start), std::memory_order_relaxed);
+    slot.duration_ns.store(nanoseconds(end) - nanoseconds(start), std::memory_order_relaxed);
+    slot.arg.store(arg, std::memory_order_relaxed);
+    thread_buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void TraceRecorder::writeChromeJson(std::ostream &out) {
+    std::lock_guard lock(registry_mutex);
+
+    std::vector<std::vector<TraceEventCopy>> threads(registry.size());
+    std::int64_t origin_ns = INT64_MAX;
+    for (std::size_t t = 0; t < registry.size(); ++t) {
+        ThreadBuffer &buffer = *registry[t];
+        std::uint64_t capacity = buffer.slots.size();
+        std::uint64_t end = buffer.head.load(std::memory_order_acquire);
+        std::uint64_t begin = std::max(buffer.cleared_at, end > capacity ? end - capacity : 0);
+        std::vector<TraceEventCopy> &events = threads[t];
+        for (std::uint64_t i = begin; i < end; ++i) {
+            const TraceSlot &slot = buffer.slots[i & (capacity - 1)];
+            events.push_back({slot.name.load(std::memory_order_relaxed), slot.start_ns.load(std::memory_order_relaxed),
+                              slot.duration_ns.load(std::memory_order_relaxed), slot.arg.load(std::memory_order_relaxed)});
+        }
+        // Slots the thread reused while they were copied hold a mix of two events, they are dropped
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        std::uint64_t first_intact = head >= capacity ? head - capacity + 1 : 0;
+        if (first_intact > begin) {
+            events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(std::min<std::uint64_t>(first_intact - begin, events.size())));
+        }
+        for (const TraceEventCopy &event : events) {
+            origin_ns = std::min(origin_ns, event.start_ns);
+        }
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    out << std::fixed << std::setprecision(3);
+    for (std::size_t t = 0; t < threads.size(); ++t) {
+        int tid = static_cast<int>(t) + 1;
+        if (!registry[t]->name.empty()) {
+            out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+            writeJsonString(out, registry[t]->name);
+            out << "}}";
+            first = false;
+        }
+        for (const TraceEventCopy &event : threads[t]) {
+            out << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << (event.start_ns - origin_ns) / 1e3 << ",\"dur\":" << event.duration_ns / 1e3;
+            if (event.arg >= 0) {
+                out << ",\"args\":{\"value\":" << event.arg << "}";
+            }
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n]}" << std::endl;
+    out << std::defaultfloat;
+}
+
+bool TraceRecorder::saveChromeJson(const std::string &path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Invalid trace path: " << path << std::endl;
+        return false;
+    }
+    writeChromeJson(file);
+    return static_cast<bool>(file);
+}
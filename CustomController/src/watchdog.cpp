@@ -0,0 +1,154 @@
+//
+// Cycle deadline and device liveness monitoring with failsafe channel output
+//
+
+#include "watchdog.h"
+#include "inputController.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+Watchdog::Watchdog(int n_channels) : failsafe_modes(n_channels, FailsafeMode::neutral), failsafe_presets(n_channels, 0), last_good_frame(n_channels, 0) {}
+
+void Watchdog::setPeriod(Clock::duration period) {
+    this->period = period;
+    restart();
+}
+
+void Watchdog::setFailsafe(int channel_index, FailsafeMode mode, ChannelDataType preset) {
+    if (channel_index < 0 || channel_index >= static_cast<int>(failsafe_modes.size())) {
+        std::cerr << "Invalid channel index: " << channel_index << std::endl;
+        return;
+    }
+    failsafe_modes[channel_index] = mode;
+    failsafe_presets[channel_index] = preset;
+}
+
+void Watchdog::watchDevice(SDL_JoystickID which) {
+    if (std::none_of(watched_devices.begin(), watched_devices.end(), [which](const WatchedDevice &device) {return device.which == which;})) {
+        watched_devices.push_back({which});
+    }
+}
+
+void Watchdog::setWatchedDevices(const std::vector<SDL_JoystickID> &ids) {
+    std::erase_if(watched_devices, [&ids](const WatchedDevice &device) {return std::find(ids.begin(), ids.end(), device.which) == ids.end();});
+    for (SDL_JoystickID which : ids) {
+        watchDevice(which);
+    }
+}
+
+void Watchdog::restart() {
+    previous_cycle = Clock::time_point{};
+    consecutive_overruns = 0;
+}
+
+bool Watchdog::apply(const Inputs &inputs, std::vector<ChannelDataType> &frame, Clock::time_point now) {
+    cycles.fetch_add(1, std::memory_order_relaxed);
+    if (neutral_frame.empty()) {
+        // Channel biases are fixed once Inputs is constructed
+        neutral_frame = inputs.getNeutralChannels();
+        neutral_frame.resize(failsafe_modes.size(), 0);
+        last_good_frame = neutral_frame;    // holding before the first healthy cycle must still send in-range values
+    }
+
+    bool overrun = false;
+    if (period.count() > 0 && previous_cycle != Clock::time_point{}) {
+        auto jitter = (now - previous_cycle) - period;
+        std::int64_t jitter_us = std::chrono::duration_cast<std::chrono::microseconds>(jitter).count();
+        last_jitter_us.store(jitter_us, std::memory_order_relaxed);
+        if (std::abs(jitter_us) > max_jitter_us.load(std::memory_order_relaxed)) {
+            max_jitter_us.store(std::abs(jitter_us), std::memory_order_relaxed);
+        }
+        if (jitter > std::chrono::duration_cast<Clock::duration>(period * config.overrun_tolerance)) {
+            overrun = true;
+            overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    previous_cycle = now;
+    consecutive_overruns = overrun ? consecutive_overruns + 1 : 0;
+
+    bool devices_ok = devicesHealthy(inputs, now);
+    if (!devices_ok && !devices_lost) {
+        device_losses.fetch_add(1, std::memory_order_relaxed);
+    }
+    devices_lost = !devices_ok;
+
+    bool healthy = devices_ok && consecutive_overruns < std::max(config.overruns_to_trip, 1);
+    if (!healthy) {
+        healthy_cycles = 0;
+        if (!failsafe.exchange(true, std::memory_order_relaxed)) {
+            failsafe_entries.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else if (failsafe.load(std::memory_order_relaxed) && ++healthy_cycles >= config.recovery_cycles) {
+        failsafe.store(false, std::memory_order_relaxed);
+    }
+
+    if (!failsafe.load(std::memory_order_relaxed)) {
+        last_good_frame.assign(frame.begin(), frame.end());
+        return false;
+    }
+
+    for (std::size_t i = 0; i < frame.size() && i < failsafe_modes.size(); ++i) {
+        switch (failsafe_modes[i]) {
+            case FailsafeMode::hold:
+                frame[i] = last_good_frame[i];
+                break;
+            case FailsafeMode::preset:
+                frame[i] = failsafe_presets[i];
+                break;
+            case FailsafeMode::neutral:
+            default:
+                frame[i] = neutral_frame[i];
+                break;
+        }
+    }
+    return true;
+}
+
+WatchdogCounters Watchdog::counters() const {
+    WatchdogCounters counters;
+    counters.cycles = cycles.load(std::memory_order_relaxed);
+    counters.overruns = overruns.load(std::memory_order_relaxed);
+    counters.failsafe_entries = failsafe_entries.load(std::memory_order_relaxed);
+    counters.device_losses = device_losses.load(std::memory_order_relaxed);
+    counters.last_jitter_us = last_jitter_us.load(std::memory_order_relaxed);
+    counters.max_jitter_us = max_jitter_us.load(std::memory_order_relaxed);
+    counters.failsafe = failsafe.load(std::memory_order_relaxed);
+    return counters;
+}
+
+void Watchdog::resetCounters() {
+    cycles.store(0, std::memory_order_relaxed);
+    overruns.store(0, std::memory_order_relaxed);
+    failsafe_entries.store(0, std::memory_order_relaxed);
+    device_losses.store(0, std::memory_order_relaxed);
+    last_jitter_us.store(0, std::memory_order_relaxed);
+    max_jitter_us.store(0, std::memory_order_relaxed);
+}
+
+bool Watchdog::devicesHealthy(const Inputs &inputs, Clock::time_point now) {
+    bool healthy = true;
+    for (WatchedDevice &device : watched_devices) {
+        if (inputs.devicePending(device.which)) {
+            // Opening in the background, wait for it at most open_timeout
+            if (device.opening_since == Clock::time_point{}) {
+                device.opening_since = now;
+            }
+            healthy = healthy && now - device.opening_since >= config.open_timeout;
+            continue;
+        }
+        if (!inputs.deviceConnected(device.which)) {
+            healthy = healthy && !device.seen;
+            continue;
+        }
+        device.seen = true;
+        device.opening_since = Clock::time_point{};
+        if (config.device_timeout.count() > 0) {
+            Clock::time_point last_input = inputs.lastDeviceInput(device.which);
+            if (last_input != Clock::time_point{} && now - last_input > config.device_timeout) {
+                healthy = false;
+            }
+        }
+    }
+    return healthy;
+}
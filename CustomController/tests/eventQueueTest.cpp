@@ -0,0 +1,159 @@
+//
+// Behavior checks for EventQueue: ring wraparound, overflow into the backlog and one producer/consumer pair
+//
+
+#include "eventQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const char *what) {
+        if (!condition) {
+            std::cerr << "FAILED: " << what << std::endl;
+            failures++;
+        }
+    }
+
+    SDL_Event key(Uint32 type, SDL_Keycode sym) {
+        SDL_Event event{};
+        event.type = type;
+        event.key.keysym.sym = sym;
+        return event;
+    }
+
+    SDL_Event axis(Uint8 index, Sint16 value) {
+        SDL_Event event{};
+        event.type = SDL_JOYAXISMOTION;
+        event.jaxis.which = 1;
+        event.jaxis.axis = index;
+        event.jaxis.value = value;
+        return event;
+    }
+
+    std::vector<SDL_Event> drain(EventQueue &queue) {
+        std::vector<SDL_Event> events;
+        SDL_Event event;
+        InputClock::time_point timestamp;
+        while (queue.pop(event, timestamp)) {
+            events.push_back(event);
+        }
+        return events;
+    }
+
+    void wraparound() {
+        EventQueue queue(3);    // rounded up to 4
+        SDL_Keycode next_pushed = 0;
+        SDL_Keycode next_popped = 0;
+        bool in_order = true;
+        for (int round = 0; round < 50; ++round) {
+            for (int i = 0; i < 3; ++i) {
+                check(queue.push(key(SDL_KEYDOWN, next_pushed++)), "pushing into a ring with room succeeds");
+            }
+            check(queue.size() == 3, "size counts the events in the ring");
+            for (const SDL_Event &event : drain(queue)) {
+                in_order = in_order && event.key.keysym.sym == next_popped++;
+            }
+        }
+        check(in_order && next_popped == next_pushed, "events come out in order across many wraparounds");
+
+        for (int i = 0; i < 4; ++i) {
+            queue.push(key(SDL_KEYDOWN, i));
+        }
+        check(queue.size() == 4, "the capacity is rounded up to a power of two");
+        queue.clear();
+        check(queue.size() == 0 && drain(queue).empty(), "clear discards the ring");
+    }
+
+    void overflow() {
+        EventQueue queue(4);
+        for (int i = 0; i < 4; ++i) {
+            queue.push(key(SDL_KEYDOWN, i));
+        }
+        check(queue.size() == 4, "the ring is full");
+
+        check(queue.push(axis(0, 100)), "the first motion of an axis is held back");
+        check(queue.push(key(SDL_KEYUP, 1)), "a release is held back, not dropped");
+        check(!queue.push(axis(0, 200)), "a newer motion of the same axis replaces the held back one");
+        check(queue.push(axis(1, 300)), "a motion of another axis is held back separately");
+        check(queue.dropped() == 1, "the replaced motion is counted");
+
+        // The backlog holds as many events as the ring, further presses are dropped but releases never are
+        check(queue.push(key(SDL_KEYDOWN, 10)), "a press is held back while the backlog has room");
+        check(!queue.push(key(SDL_KEYDOWN, 11)), "a press is dropped once the backlog is full");
+        check(queue.push(key(SDL_KEYUP, 10)), "a release is kept even with a full backlog");
+        check(queue.dropped() == 2, "the dropped press is counted");
+
+        check(drain(queue).size() == 4, "only the ring is read");
+        queue.retry();
+        std::vector<SDL_Event> held = drain(queue);
+        check(held.size() == 4, "retry moves held back events as far as the ring has room");
+        queue.retry();
+        std::vector<SDL_Event> rest = drain(queue);
+        held.insert(held.end(), rest.begin(), rest.end());
+
+        check(held.size() == 5, "every held back event arrives");
+        if (held.size() == 5) {
+            check(held[0].type == SDL_JOYAXISMOTION && held[0].jaxis.axis == 0 && held[0].jaxis.value == 200,
+                  "a replaced motion keeps its place and carries the latest value");
+            check(held[1].type == SDL_KEYUP && held[1].key.keysym.sym == 1, "held back events keep their order");
+            check(held[2].type == SDL_JOYAXISMOTION && held[2].jaxis.axis == 1, "the second axis follows");
+            check(held[3].type == SDL_KEYDOWN && held[3].key.keysym.sym == 10, "the held back press follows");
+            check(held[4].type == SDL_KEYUP && held[4].key.keysym.sym == 10, "the release comes last");
+        }
+
+        check(queue.push(key(SDL_KEYDOWN, 20)) && queue.size() == 1, "an empty backlog writes straight into the ring");
+    }
+
+    // Releases are never dropped, so with one producer and one consumer every one of them must arrive in order
+    void producerConsumer() {
+        constexpr int n_events = 100000;
+        EventQueue queue(64);
+        std::atomic<bool> consumed{false};
+
+        std::thread producer([&] {
+            for (int i = 0; i < n_events; ++i) {
+                queue.push(key(SDL_KEYUP, i));
+            }
+            while (!consumed.load()) {
+                queue.retry();
+                std::this_thread::yield();
+            }
+        });
+
+        int expected = 0;
+        bool in_order = true;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (expected < n_events && std::chrono::steady_clock::now() < deadline) {
+            SDL_Event event;
+            InputClock::time_point timestamp;
+            if (queue.pop(event, timestamp)) {
+                in_order = in_order && event.key.keysym.sym == expected;
+                expected++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        consumed.store(true);
+        producer.join();
+
+        check(expected == n_events, "every release arrives");
+        check(in_order, "releases arrive in the order they were pushed");
+        check(queue.dropped() == 0, "releases are never dropped");
+    }
+}
+
+int main() {
+    wraparound();
+    overflow();
+    producerConsumer();
+    if (failures == 0) {
+        std::cout << "eventQueueTest passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+//
+// Behavior checks for TimingWheel: cascading across levels, past deadlines and cancelling
+//
+
+#include "timingWheel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const char *what) {
+        if (!condition) {
+            std::cerr << "FAILED: " << what << std::endl;
+            failures++;
+        }
+    }
+
+    const InputClock::time_point start = InputClock::time_point{} + std::chrono::hours(1);
+
+    InputClock::time_point at(std::int64_t ms) {
+        return start + std::chrono::milliseconds(ms);
+    }
+
+    // Timers on every level and on level boundaries fire once, in order and in the advance() that reaches them
+    void cascadeAcrossLevels() {
+        TimingWheel wheel(std::chrono::milliseconds(1), start);
+        const std::vector<std::int64_t> deadlines = {
+            1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097, 70000, 262143, 262144, 300001,
+            (std::int64_t{1} << 24) + 5     // beyond the top level, parked and moved down again
+        };
+        for (std::int64_t deadline : deadlines) {
+            wheel.schedule(at(deadline), static_cast<std::uint64_t>(deadline));
+        }
+        check(wheel.pending() == deadlines.size(), "every timer is pending");
+
+        std::vector<std::int64_t> fired;
+        bool early = false;
+        std::int64_t now = 0;
+        while (wheel.pending() > 0 && now < (std::int64_t{1} << 25)) {
+            now += now < 400000 ? 7 : 4099;
+            wheel.advance(at(now), [&](std::uint64_t payload) {
+                early = early || static_cast<std::int64_t>(payload) > now;
+                fired.push_back(static_cast<std::int64_t>(payload));
+            });
+            for (std::int64_t deadline : deadlines) {
+                // Anything due must have fired by the end of this advance
+                if (deadline <= now && std::find(fired.begin(), fired.end(), deadline) == fired.end()) {
+                    check(false, "a due timer fires in the advance that reaches it");
+                    return;
+                }
+            }
+        }
+        check(!early, "no timer fires before its deadline");
+        check(fired == deadlines, "every timer fires exactly once, in expiry order");
+    }
+
+    // Deadlines already passed expire on the next advance, not never and not immediately
+    void pastDeadlines() {
+        TimingWheel wheel(std::chrono::milliseconds(1), start);
+        int n_fired = 0;
+        wheel.advance(at(500), [&](std::uint64_t) {n_fired++;});
+
+        wheel.schedule(at(100), 1);
+        wheel.schedule(start - std::chrono::seconds(1), 2);
+        wheel.schedule(at(500), 3);
+        check(n_fired == 0, "scheduling never fires");
+
+        std::vector<std::uint64_t> fired;
+        wheel.advance(at(501), [&](std::uint64_t payload) {fired.push_back(payload);});
+        check(fired.size() == 3, "past deadlines fire on the next tick");
+        check(wheel.pending() == 0, "nothing left after past deadlines fired");
+    }
+
+    void cancelling() {
+        TimingWheel wheel(std::chrono::milliseconds(1), start);
+        TimingWheel::TimerId near = wheel.schedule(at(10), 1);
+        TimingWheel::TimerId far = wheel.schedule(at(10000), 2);
+        TimingWheel::TimerId kept = wheel.schedule(at(20), 3);
+        check(wheel.cancel(near), "a pending timer can be cancelled");
+        check(wheel.cancel(far), "a timer on an upper level can be cancelled");
+        check(!wheel.cancel(near), "cancelling twice fails");
+        check(!wheel.cancel(0), "0 is never a timer");
+
+        std::vector<std::uint64_t> fired;
+        wheel.advance(at(20000), [&](std::uint64_t payload) {fired.push_back(payload);});
+        check(fired == std::vector<std::uint64_t>{3}, "cancelled timers never fire");
+        check(!wheel.cancel(kept), "an expired timer cannot be cancelled");
+
+        // The node of 'near' is reused, its old id must not cancel the new timer
+        TimingWheel::TimerId reused = wheel.schedule(at(20010), 4);
+        check(!wheel.cancel(near), "a stale id does not cancel a reused node");
+        check(wheel.cancel(reused), "the new id does");
+    }
+
+    // fire may schedule further timers, including ones due within the same advance
+    void schedulingFromFire() {
+        TimingWheel wheel(std::chrono::milliseconds(1), start);
+        wheel.schedule(at(5), 1);
+        std::vector<std::uint64_t> fired;
+        wheel.advance(at(100), [&](std::uint64_t payload) {
+            fired.push_back(payload);
+            if (payload < 3) {
+                wheel.schedule(at(5 + 10 * static_cast<std::int64_t>(payload)), payload + 1);
+            }
+        });
+        check(fired == std::vector<std::uint64_t>{1, 2, 3}, "timers scheduled from fire run in the same advance");
+        check(wheel.pending() == 0, "nothing left after rescheduling");
+    }
+}
+
+int main() {
+    cascadeAcrossLevels();
+    pastDeadlines();
+    cancelling();
+    schedulingFromFire();
+    if (failures == 0) {
+        std::cout << "timingWheelTest passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -4,22 +4,40 @@
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <iostream>
+#include <cstring>
 #include <SDL.h>
 
 #include "inputController.h"
+#include "startupTimeline.h"
 #include "../src/QmlControllerApi.h"
 
 int main(int argc, char *argv[]) {    
+    StartupTimeline startup;
+    startup.mark("start");
+
+    // --full-init brings up every SDL subsystem and opens all devices before the first frame, as before
+    bool full_init = false;
+    for (int i = 1; i < argc; ++i) {
+        full_init |= std::strcmp(argv[i], "--full-init") == 0;
+    }
+
     // Start QML
     QGuiApplication app(argc, argv);
+    startup.mark("qt app");
 
-    if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+    // Only events and game controllers (which includes joysticks) are needed, video, audio, haptic
+    // and sensors are skipped
+    if (SDL_Init(full_init ? SDL_INIT_EVERYTHING : SDL_INIT_EVENTS | SDL_INIT_GAMECONTROLLER) != 0) {
         std::cout << "SDL_InitSubSystem Error: " << SDL_GetError() << std::endl;
         return false;
     }
+    startup.mark("sdl init");
 
-    Inputs sdlController(16); // Create controller with 16 channels
+    Inputs sdlController(16, full_init ? DeviceOpening::eager : DeviceOpening::background); // Create controller with 16 channels
+    startup.mark("inputs");
     QmlControllerApi inputController(sdlController);
+    startup.mark("config");
+    inputController.setStartupTimeline(&startup);
     inputController.setDebug(false);
     inputController.setChannelsCallback([](const std::vector<ChannelDataType>& channels) {
         // Example callback function to print channel values
@@ -43,6 +61,7 @@ int main(int argc, char *argv[]) {
         []() { QCoreApplication::exit(-1); },
         Qt::QueuedConnection);
     engine.load(url);
+    startup.mark("qml");
         
     //inputController.startPolling(50);
     int result_app = app.exec();
@@ -20,8 +20,15 @@ ColumnLayout {
     signal clearConfig()
 
     property var selected_behaviour: 0
+    property bool is_axis: false    // axes have no REPEAT, DOUBLE_TAP or LONG_PRESS, the last three modes
     property int value_offset: 0
 
+    onIs_axisChanged: {
+        if (ch_settings.is_axis && ch_settings.selected_behaviour > 7) {
+            ch_settings.selected_behaviour = 0
+        }
+    }
+
     // Existing channel settings row
     RowLayout {
         Text {
@@ -48,7 +55,8 @@ ColumnLayout {
         ComboBox {
             id: behaviour_selector
             Layout.minimumWidth: 150
-            model: ["NONE", "RAW", "TAP", "HOLD", "RELEASE", "INCREMENT", "TOGGLE", "TOGGLE_SYMETRIC"]
+            property var modes: ["NONE", "RAW", "TAP", "HOLD", "RELEASE", "INCREMENT", "TOGGLE", "TOGGLE_SYMETRIC", "REPEAT", "DOUBLE_TAP", "LONG_PRESS"]
+            model: ch_settings.is_axis ? modes.slice(0, 8) : modes
 
             // Bind the currentIndex to the property
             currentIndex: ch_settings.selected_behaviour
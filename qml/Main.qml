@@ -57,6 +57,22 @@ ApplicationWindow {
                     onClicked: SdlController.saveConfig()
                 }
 
+                MessageDialog {
+                    id: saveFailedDialog
+                    title: "Save Config"
+                    text: "The config file could not be written."
+                    buttons: MessageDialog.Ok
+                }
+
+                Connections {
+                    target: SdlController
+                    onConfigSaved: {
+                        if (!success) {
+                            saveFailedDialog.open()
+                        }
+                    }
+                }
+
                 TextInput {
                     id: pollingRateInput
                     property int pollingRate: 100   // default value
@@ -66,13 +82,14 @@ ApplicationWindow {
                     color: Universal.baseHighColor
                     horizontalAlignment: Text.AlignHCenter
                     verticalAlignment: Text.AlignVCenter
-                    validator: IntValidator { bottom: 50; top: 250 }
+                    validator: IntValidator { bottom: 1; top: 1000 }
 
                     onEditingFinished: {
                         const val = parseInt(text, 10)
                         if (!isNaN(val)) {
                             pollingRate = val
                             text = val.toString()  // Ensure text is valid
+                            SdlController.setPollingInterval(val)
                         } else {
                             text = pollingRate.toString()  // Revert invalid input
                         }
@@ -83,7 +100,7 @@ ApplicationWindow {
                 Button {
                     text: "Start Polling"
                     Layout.preferredWidth: 150
-                    onClicked: SdlController.startPolling()
+                    onClicked: SdlController.startPolling(pollingRateInput.pollingRate)
                 }
 
                 Button {
@@ -130,6 +147,7 @@ ApplicationWindow {
                                 if (child) {
                                     child.input_label = SdlController.getChannelInputLabel(i)
                                     child.checked = false
+                                    child.is_axis = SdlController.isAxisInput(i)
                                     child.selected_behaviour = SdlController.getMode(i)
                                     child.value_offset = SdlController.getChannelOffset(i)
                                 }
@@ -154,6 +172,7 @@ ApplicationWindow {
                     var inputText = SdlController.getInput(ch_id) // blocks here, but after QML updates
                     if (inputText && inputText.length > 0) {
                         child.input_label = inputText
+                        child.is_axis = SdlController.isAxisInput(ch_id)
                     }
                     child.checked = false
                 })
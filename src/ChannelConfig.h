@@ -1,22 +1,38 @@
 #pragma once
 #include <SDL.h>
 #include <variant>
+#include <vector>
 
 enum class InputType {
     None,
     Keyboard,
     JoystickButton,
-    JoystickAxis
+    JoystickAxis,
+    JoystickHat
 };
 
 struct JoystickButton {
     Uint8 button;
     SDL_JoystickID joystick_id;
+    bool controller = false;    // reported as a game controller button (SDL_CONTROLLERBUTTON*), not a joystick one
+
+    bool operator==(const JoystickButton&) const = default;
 };
 
 struct JoystickAxis {
     Uint8 axis;
     SDL_JoystickID joystick_id;
+    bool controller = false;    // reported as a game controller axis (SDL_CONTROLLERAXISMOTION)
+
+    bool operator==(const JoystickAxis&) const = default;
+};
+
+struct JoystickHat {
+    Uint8 hat;
+    Uint8 direction;    // single SDL_HAT_* direction
+    SDL_JoystickID joystick_id;
+
+    bool operator==(const JoystickHat&) const = default;
 };
 
 enum class ChannelModes {
@@ -28,6 +44,9 @@ enum class ChannelModes {
     INCREMENT,
     TOGGLE,
     TOGGLE_SYMETRIC,
+    REPEAT,
+    DOUBLE_TAP,
+    LONG_PRESS,
 };
 
 struct ChannelConfig {
@@ -35,9 +54,10 @@ struct ChannelConfig {
     InputType type = InputType::None;
     SDL_Event raw_event;
 
-    using InputVariant = std::variant<std::monostate, SDL_Keycode, JoystickButton, JoystickAxis>;
+    using InputVariant = std::variant<std::monostate, SDL_Keycode, JoystickButton, JoystickAxis, JoystickHat>;
 
     InputVariant input_data;
+    std::vector<InputVariant> modifiers;    // keys, buttons or hat directions held together with input_data
     int offset;
     ChannelModes mode = ChannelModes::NONE;
 };
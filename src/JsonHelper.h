@@ -4,9 +4,47 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QFile>
+#include <QSaveFile>
 #include <iostream>
 #include "ChannelConfig.h"
 
+// Convert a chord modifier -> QJsonObject, same fields as the channel's own input
+inline QJsonObject modifierToJson(const ChannelConfig::InputVariant& modifier) {
+    QJsonObject obj;
+    if (std::holds_alternative<SDL_Keycode>(modifier)) {
+        obj["input_type"] = "keyboard";
+        obj["keycode"] = QString::fromUtf8(SDL_GetKeyName(std::get<SDL_Keycode>(modifier)));
+    } else if (std::holds_alternative<JoystickButton>(modifier)) {
+        const auto& jb = std::get<JoystickButton>(modifier);
+        obj["input_type"] = "joystick_button";
+        obj["button"] = jb.button;
+        obj["joystick_id"] = jb.joystick_id;
+        if (jb.controller)
+            obj["controller"] = true;
+    } else if (std::holds_alternative<JoystickHat>(modifier)) {
+        const auto& jh = std::get<JoystickHat>(modifier);
+        obj["input_type"] = "joystick_hat";
+        obj["hat"] = jh.hat;
+        obj["direction"] = jh.direction;
+        obj["joystick_id"] = jh.joystick_id;
+    } else {
+        obj["input_type"] = "none";     // axes can't be held as modifiers
+    }
+    return obj;
+}
+
+// Convert QJsonObject -> chord modifier
+inline ChannelConfig::InputVariant modifierFromJson(const QJsonObject& obj) {
+    QString inputType = obj["input_type"].toString();
+    if (inputType == "keyboard")
+        return SDL_GetKeyFromName(obj["keycode"].toString().toUtf8().constData());
+    if (inputType == "joystick_button")
+        return JoystickButton{static_cast<Uint8>(obj["button"].toInt()), static_cast<SDL_JoystickID>(obj["joystick_id"].toInt()), obj["controller"].toBool(false)};
+    if (inputType == "joystick_hat")
+        return JoystickHat{static_cast<Uint8>(obj["hat"].toInt()), static_cast<Uint8>(obj["direction"].toInt()), static_cast<SDL_JoystickID>(obj["joystick_id"].toInt())};
+    return std::monostate{};
+}
+
 // Convert ChannelConfig -> QJsonObject
 inline QJsonObject channelConfigToJson(const ChannelConfig& cfg) {
     QJsonObject obj;
@@ -24,15 +62,33 @@ inline QJsonObject channelConfigToJson(const ChannelConfig& cfg) {
         obj["input_type"] = "joystick_button";
         obj["button"] = jb.button;
         obj["joystick_id"] = jb.joystick_id;
+        if (jb.controller)
+            obj["controller"] = true;
     } else if (std::holds_alternative<JoystickAxis>(cfg.input_data)) {
         const auto& ja = std::get<JoystickAxis>(cfg.input_data);
         obj["input_type"] = "joystick_axis";
         obj["axis"] = ja.axis;
         obj["joystick_id"] = ja.joystick_id;
+        if (ja.controller)
+            obj["controller"] = true;
+    } else if (std::holds_alternative<JoystickHat>(cfg.input_data)) {
+        const auto& jh = std::get<JoystickHat>(cfg.input_data);
+        obj["input_type"] = "joystick_hat";
+        obj["hat"] = jh.hat;
+        obj["direction"] = jh.direction;
+        obj["joystick_id"] = jh.joystick_id;
     } else {
         obj["input_type"] = "none";
     }
 
+    // Written only for chords, configs without modifiers stay as they were
+    if (!cfg.modifiers.empty()) {
+        QJsonArray modifiers;
+        for (const auto& modifier : cfg.modifiers)
+            modifiers.append(modifierToJson(modifier));
+        obj["modifiers"] = modifiers;
+    }
+
     return obj;
 }
 
@@ -60,26 +116,55 @@ inline ChannelConfig channelConfigFromJson(const QJsonObject& obj) {
         JoystickButton jb;
         jb.button = static_cast<Uint8>(obj["button"].toInt());
         jb.joystick_id = static_cast<SDL_JoystickID>(obj["joystick_id"].toInt());
+        jb.controller = obj["controller"].toBool(false);
         cfg.input_data = jb;
 
         // restore raw_event
         SDL_Event ev{};
-        ev.type = SDL_JOYBUTTONDOWN;
-        ev.jbutton.button = jb.button;
-        ev.jbutton.which = jb.joystick_id;
+        if (jb.controller) {
+            ev.type = SDL_CONTROLLERBUTTONDOWN;
+            ev.cbutton.button = jb.button;
+            ev.cbutton.which = jb.joystick_id;
+        } else {
+            ev.type = SDL_JOYBUTTONDOWN;
+            ev.jbutton.button = jb.button;
+            ev.jbutton.which = jb.joystick_id;
+        }
         cfg.raw_event = ev;
 
     } else if (inputType == "joystick_axis") {
         JoystickAxis ja; 
         ja.axis = static_cast<Uint8>(obj["axis"].toInt());
         ja.joystick_id = static_cast<SDL_JoystickID>(obj["joystick_id"].toInt());
+        ja.controller = obj["controller"].toBool(false);
         cfg.input_data = ja;
 
         // restore raw_event
         SDL_Event ev{};
-        ev.type = SDL_JOYAXISMOTION;
-        ev.jaxis.axis = ja.axis;
-        ev.jaxis.which = ja.joystick_id;
+        if (ja.controller) {
+            ev.type = SDL_CONTROLLERAXISMOTION;
+            ev.caxis.axis = ja.axis;
+            ev.caxis.which = ja.joystick_id;
+        } else {
+            ev.type = SDL_JOYAXISMOTION;
+            ev.jaxis.axis = ja.axis;
+            ev.jaxis.which = ja.joystick_id;
+        }
+        cfg.raw_event = ev;
+
+    } else if (inputType == "joystick_hat") {
+        JoystickHat jh;
+        jh.hat = static_cast<Uint8>(obj["hat"].toInt());
+        jh.direction = static_cast<Uint8>(obj["direction"].toInt());
+        jh.joystick_id = static_cast<SDL_JoystickID>(obj["joystick_id"].toInt());
+        cfg.input_data = jh;
+
+        // restore raw_event
+        SDL_Event ev{};
+        ev.type = SDL_JOYHATMOTION;
+        ev.jhat.hat = jh.hat;
+        ev.jhat.value = jh.direction;
+        ev.jhat.which = jh.joystick_id;
         cfg.raw_event = ev;
 
     } else {
@@ -87,32 +172,51 @@ inline ChannelConfig channelConfigFromJson(const QJsonObject& obj) {
         cfg.raw_event = SDL_Event{};  // clear
     }
 
+    for (const auto& v : obj["modifiers"].toArray()) {
+        ChannelConfig::InputVariant modifier = modifierFromJson(v.toObject());
+        if (!std::holds_alternative<std::monostate>(modifier))
+            cfg.modifiers.push_back(modifier);
+    }
+
     return cfg;
 }
 
 
-// Save vector<ChannelConfig> to JSON file
-inline bool saveChannelConfigs(const QString& filePath, const std::vector<ChannelConfig>& configs) {
+// Two configs bind the same input the same way when they serialize identically
+inline bool sameChannelConfig(const ChannelConfig& a, const ChannelConfig& b) {
+    return channelConfigToJson(a) == channelConfigToJson(b);
+}
+
+// Serialize vector<ChannelConfig> to JSON bytes
+inline QByteArray channelConfigsToJson(const std::vector<ChannelConfig>& configs) {
     QJsonArray arr;
     for (const auto& cfg : configs)
         arr.append(channelConfigToJson(cfg));
 
-    QJsonDocument doc(arr);
-    QFile file(filePath);
+    return QJsonDocument(arr).toJson();
+}
+
+// Write JSON bytes to a temporary file next to filePath and rename it over filePath,
+// so a crash or a full disk leaves either the old or the new file, never a partial one
+inline bool writeConfigFile(const QString& filePath, const QByteArray& data) {
+    QSaveFile file(filePath);
     if (!file.open(QIODevice::WriteOnly))
         return false;
 
-    file.write(doc.toJson());
-    return true;
+    if (file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
 }
 
-// Load vector<ChannelConfig> from JSON file
-inline bool loadChannelConfigs(const QString& filePath, std::vector<ChannelConfig>& configs) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly))
-        return false;
+// Save vector<ChannelConfig> to JSON file
+inline bool saveChannelConfigs(const QString& filePath, const std::vector<ChannelConfig>& configs) {
+    return writeConfigFile(filePath, channelConfigsToJson(configs));
+}
 
-    QByteArray data = file.readAll();
+// Parse vector<ChannelConfig> from JSON bytes
+inline bool parseChannelConfigs(const QByteArray& data, std::vector<ChannelConfig>& configs) {
     QJsonDocument doc = QJsonDocument::fromJson(data);
     if (!doc.isArray())
         return false;
@@ -125,3 +229,12 @@ inline bool loadChannelConfigs(const QString& filePath, std::vector<ChannelConfi
     }
     return true;
 }
+
+// Load vector<ChannelConfig> from JSON file
+inline bool loadChannelConfigs(const QString& filePath, std::vector<ChannelConfig>& configs) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    return parseChannelConfigs(file.readAll(), configs);
+}
@@ -1,11 +1,16 @@
 #include "QmlControllerApi.h"
 
 #include <QVariantList>
+#include <QGuiApplication>
+#include <QScreen>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <SDL.h>
 
 // QJSON for config save/load
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -13,110 +18,510 @@
 
 
 QmlControllerApi::QmlControllerApi(Inputs& controller, QObject *parent) 
-    : QObject(parent), SdlController(controller), m_channels(controller.getChannels().size()), m_channel_config(controller.getChannels().size()) {
+    : QObject(parent), SdlController(controller), m_channels(controller.getChannels().size()), m_channel_config(controller.getChannels().size()), m_watchdog(static_cast<int>(controller.getChannels().size())),
+      m_ui_channels(m_channels.size()), m_ui_min(m_channels.size()), m_ui_max(m_channels.size()), m_frame_min(m_channels.size()), m_frame_max(m_channels.size()), m_interpolator(static_cast<int>(controller.getChannels().size())) {
     std::cout << "SDL Controller API: Initialized " << std::endl;
-    connect(&m_timer, &QTimer::timeout, this, &QmlControllerApi::updateInputs);
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &QmlControllerApi::pollTick);
     for (size_t i = 0; i < m_channel_config.size(); ++i) {
         m_channel_config[i].channel = static_cast<int>(i);
     }
 
+    m_config_io.setMaxThreadCount(1);
+    m_reload_timer.setSingleShot(true);
+    m_reload_timer.setInterval(100);
+    connect(&m_reload_timer, &QTimer::timeout, this, &QmlControllerApi::reloadConfigFile);
+    connect(&m_config_watcher, &QFileSystemWatcher::fileChanged, &m_reload_timer, qOverload<>(&QTimer::start));
+    connect(&m_config_watcher, &QFileSystemWatcher::directoryChanged, &m_reload_timer, qOverload<>(&QTimer::start));
+
+    setUiRefreshRate(0);
     loadConfig();
 }
 
 QmlControllerApi::~QmlControllerApi() {
     std::cout << "SDL Controller API: Stopped" << std::endl;
     stopPolling();
+    m_config_io.waitForDone();
+    disableOutputInterpolation();
+    m_outputs.clear();
+    SdlController.setHistory(nullptr);
 }
 
 void QmlControllerApi::updateInputs() {
+    TRACE_SCOPE("updateInputs");
     SdlController.cycle(m_channels);
+
+    // Replace the frame with failsafe values when the cycle was late or a bound device went silent
+    bool failsafe;
+    {
+        TRACE_SCOPE("watchdog");
+        failsafe = m_watchdog.apply(SdlController, m_channels);
+    }
+    bool failsafe_changed = failsafe != m_failsafe_active;
+    if (failsafe_changed) {
+        m_failsafe_active = failsafe;
+        std::cout << "SDL Controller API: Failsafe " << (failsafe ? "engaged" : "released") << std::endl;
+        emit failsafeActiveChanged();
+    }
+
     if (debug) {
         printChannels(m_channels);
     }
     
-    
-    if (channels_callback) {
-        channels_callback(m_channels); // call the callback
+    {
+        TRACE_SCOPE("callback");
+        // A cycle where no update group was due repeats the previous frame, it is not sent again
+        std::uint64_t fresh = failsafe || failsafe_changed ? Inputs::all_groups : SdlController.freshGroups();
+        if (fresh && m_interpolator.running() && failsafe) {
+            // Failsafe values apply at once, they never ramp in
+            m_interpolator.jumpTo(m_channels);
+        } else if (fresh && m_interpolator.running()) {
+            // Fed only the frame the watchdog finished, live values never reach the output during failsafe
+            m_interpolator.setTarget(m_channels);
+        } else if (fresh) {
+            m_outputs.publish(m_channels, InputClock::now(), fresh);
+        }
     }
     
+    if (m_startup && !m_startup_done) {
+        markStartup();
+    }
+
+    // QML only re-evaluates bindings at the UI rate, whatever the polling rate
+    aggregateUiFrame();
+    if (DeadlineClock::Clock::now() >= m_next_ui_publish) {
+        TRACE_SCOPE("qml signals");
+        publishUiFrame();
+        emit watchdogCountersChanged();
+    }
+}
+
+void QmlControllerApi::markStartup() {
+    // The first frame may go out before the application finished starting, the breakdown completes on a later one
+    if (!m_startup->marked("first frame")) {
+        m_startup->mark("first frame");
+        return;
+    }
+    if (SdlController.devicesPending() == 0) {
+        m_startup->mark("devices open");
+        m_startup->print(std::cout);
+        m_startup_done = true;
+    }
+}
+
+void QmlControllerApi::startTrace(int eventsPerThread) {
+    if (eventsPerThread <= 0) {
+        qWarning() << "SDL Controller API: Invalid trace buffer size:" << eventsPerThread;
+        return;
+    }
+    TraceRecorder::nameThread("polling");
+    TraceRecorder::clear();
+    TraceRecorder::start(static_cast<std::size_t>(eventsPerThread));
+}
+
+void QmlControllerApi::stopTrace() {
+    TraceRecorder::stop();
+}
+
+bool QmlControllerApi::saveTrace(const QString& filePath) {
+    if (!TraceRecorder::saveChromeJson(filePath.toStdString())) {
+        qWarning() << "SDL Controller API: Could not save trace to" << filePath;
+        return false;
+    }
+    return true;
+}
+
+QVariantList QmlControllerApi::startupTimings() const {
+    QVariantList list;
+    if (!m_startup) {
+        return list;
+    }
+    for (const StartupPhase &phase : m_startup->phases()) {
+        QVariantMap map;
+        map["name"] = QString::fromStdString(phase.name);
+        map["atMs"] = phase.at_ms;
+        map["tookMs"] = phase.took_ms;
+        list.append(map);
+    }
+    return list;
+}
+
+void QmlControllerApi::aggregateUiFrame() {
+    for (std::size_t i = 0; i < m_channels.size(); ++i) {
+        m_frame_min[i] = m_ui_aggregate_empty ? m_channels[i] : std::min(m_frame_min[i], m_channels[i]);
+        m_frame_max[i] = m_ui_aggregate_empty ? m_channels[i] : std::max(m_frame_max[i], m_channels[i]);
+    }
+    m_ui_aggregate_empty = false;
+}
+
+void QmlControllerApi::publishUiFrame() {
+    auto now = DeadlineClock::Clock::now();
+    m_next_ui_publish = std::max(m_next_ui_publish + m_ui_period, now);
+    if (m_ui_aggregate_empty) {
+        aggregateUiFrame();
+    }
+    m_ui_channels = m_channels;
+    m_ui_min.swap(m_frame_min);
+    m_ui_max.swap(m_frame_max);
+    m_ui_aggregate_empty = true;
     emit channelValuesChanged(); // Notify QML to refresh the ListView
 }
 
-void QmlControllerApi::startPolling(int intervalHz) {
-    SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
-    m_intervalHz = intervalHz;
-    int intervalMs = 1000 / intervalHz;
+void QmlControllerApi::setUiRefreshRate(double rateHz) {
+    double effective_hz = rateHz;
+    if (!(rateHz > 0)) {
+        auto *gui_app = qobject_cast<QGuiApplication*>(QCoreApplication::instance());
+        QScreen *screen = gui_app ? gui_app->primaryScreen() : nullptr;
+        effective_hz = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60.0;
+        rateHz = 0;
+    }
+    m_ui_period = std::chrono::nanoseconds(static_cast<std::int64_t>(1e9 / effective_hz));
+    m_next_ui_publish = DeadlineClock::Clock::now();
+    if (m_ui_rate_hz != rateHz) {
+        m_ui_rate_hz = rateHz;
+        emit uiRefreshRateChanged();
+    }
+}
 
-    if (!m_timer.isActive()) {
-        m_timer.start(intervalMs);
-    } else {
-        m_timer.setInterval(intervalMs);
+void QmlControllerApi::pollTick() {
+    auto woke = DeadlineClock::Clock::now();
+    updateInputs();
+    m_clock.tick(woke);
+    scheduleNextPoll();
+
+    // Counters change every tick, bindings only need a few refreshes per second
+    if (woke - m_last_stats_emit >= std::chrono::milliseconds(250)) {
+        TRACE_SCOPE("qml signals");
+        m_last_stats_emit = woke;
+        emit statsChanged();
     }
 }
 
-void QmlControllerApi::setPollingInterval(int intervalHz) {
+void QmlControllerApi::scheduleNextPoll() {
+    // QTimer has millisecond resolution; rounding to the nearest one keeps the wake-up error within half a
+    // millisecond while the absolute deadlines keep the average rate exact
+    auto remaining = std::chrono::round<std::chrono::milliseconds>(m_clock.deadline() - DeadlineClock::Clock::now());
+    m_timer.start(std::max(remaining, std::chrono::milliseconds(0)));
+}
+
+QVariantMap QmlControllerApi::statsSnapshot() const {
+    InputStatsSnapshot input_stats = SdlController.statsSnapshot();
+    QVariantMap events;
+    for (std::size_t i = 0; i < input_stats.events.size(); ++i) {
+        events[InputStatsSnapshot::eventName(static_cast<StatEvent>(i))] = static_cast<qulonglong>(input_stats.events[i]);
+    }
+    QVariantList clamps;
+    QVariantList wraps;
+    for (std::size_t i = 0; i < input_stats.clamps.size(); ++i) {
+        clamps.append(static_cast<qulonglong>(input_stats.clamps[i]));
+        wraps.append(static_cast<qulonglong>(input_stats.wraps[i]));
+    }
+
+    QVariantMap map;
+    map["events"] = events;
+    map["eventsIgnored"] = static_cast<qulonglong>(input_stats.events_ignored);
+    map["behaviorsEvaluated"] = static_cast<qulonglong>(input_stats.behaviors_evaluated);
+    map["cycles"] = static_cast<qulonglong>(input_stats.cycles);
+    map["cycleMinUs"] = input_stats.cycle_min_us;
+    map["cycleAvgUs"] = input_stats.cycle_avg_us;
+    map["cycleMaxUs"] = input_stats.cycle_max_us;
+    map["clamps"] = clamps;
+    map["wraps"] = wraps;
+    map["configRebuilds"] = static_cast<qulonglong>(input_stats.config_rebuilds);
+    map["polling"] = pollingStats();
+    map["output"] = outputStats();
+    map["sinks"] = outputSinkStats();
+    map["watchdog"] = watchdogCounters();
+    return map;
+}
+
+void QmlControllerApi::resetStats() {
+    SdlController.resetStats();
+    m_clock.resetStats();
+    m_watchdog.resetCounters();
+    m_outputs.resetStats();
+    emit statsChanged();
+}
+
+void QmlControllerApi::startPolling(double intervalHz) {
+    if (!(intervalHz > 0)) {
+        qWarning() << "SDL Controller API: Invalid polling rate:" << intervalHz;
+        return;
+    }
+    SdlController.flushEvents();
+    m_intervalHz = intervalHz;
+    m_clock.setRate(intervalHz);
+    m_clock.restart();
+    m_watchdog.setPeriod(m_clock.period());
+
+    m_polling = true;
+    // The first frame goes out now, not one period later: neutral values, or failsafe while bound devices are still opening
+    pollTick();
+}
+
+void QmlControllerApi::setPollingInterval(double intervalHz) {
+    if (!(intervalHz > 0)) {
+        qWarning() << "SDL Controller API: Invalid polling rate:" << intervalHz;
+        return;
+    }
     m_intervalHz = intervalHz;
-    int intervalMs = 1000 / intervalHz;
+    m_clock.setRate(intervalHz);
+    m_watchdog.setPeriod(m_clock.period());
 
-    if (m_timer.isActive())
-        m_timer.setInterval(intervalMs);
+    if (m_polling)
+        scheduleNextPoll();
 }
 
 void QmlControllerApi::stopPolling() {
+    m_polling = false;
     m_timer.stop();
 }
 
+static QVariantMap rateStatsMap(const RateStats &stats) {
+    QVariantMap map;
+    map["targetHz"] = stats.target_hz;
+    map["achievedHz"] = stats.achieved_hz;
+    map["meanJitterUs"] = stats.mean_jitter_us;
+    map["maxJitterUs"] = stats.max_jitter_us;
+    map["ticks"] = static_cast<qulonglong>(stats.ticks);
+    map["missed"] = static_cast<qulonglong>(stats.missed);
+    return map;
+}
+
+void QmlControllerApi::setChannelsCallback(std::function<void(const std::vector<ChannelDataType>&)> cb) {
+    if (m_callback_sink >= 0) {
+        m_outputs.removeSink(m_callback_sink);
+        m_callback_sink = -1;
+    }
+    if (cb) {
+        SinkConfig config;
+        config.name = "callback";
+        config.policy = DropPolicy::latest;
+        config.queue_depth = 64;
+        m_callback_sink = m_outputs.addSink([cb = std::move(cb)](const OutputFrame &frame) {cb(frame.channels);}, std::move(config));
+    }
+}
+
+QVariantList QmlControllerApi::outputSinkStats() const {
+    QVariantList list;
+    for (const SinkStats &sink_stats : m_outputs.stats()) {
+        QVariantMap map;
+        map["id"] = sink_stats.id;
+        map["name"] = QString::fromStdString(sink_stats.name);
+        map["offered"] = static_cast<qulonglong>(sink_stats.offered);
+        map["delivered"] = static_cast<qulonglong>(sink_stats.delivered);
+        map["dropped"] = static_cast<qulonglong>(sink_stats.dropped);
+        map["queued"] = static_cast<qulonglong>(sink_stats.queued);
+        map["meanLagUs"] = sink_stats.mean_lag_us;
+        map["maxLagUs"] = sink_stats.max_lag_us;
+        list.append(map);
+    }
+    return list;
+}
+
+QVariantMap QmlControllerApi::pollingStats() const {
+    return rateStatsMap(m_clock.stats());
+}
+
+bool QmlControllerApi::setChannelGroup(int channelIndex, int group) {
+    if (channelIndex < 0 || channelIndex >= static_cast<int>(m_channel_config.size()) || group < 0 || group >= Inputs::max_update_groups) {
+        qWarning() << "SDL Controller API: Invalid update group" << group << "for channel" << channelIndex;
+        return false;
+    }
+    SdlController.setChannelGroup(channelIndex, group);
+    return true;
+}
+
+bool QmlControllerApi::setGroupRate(int group, double rateHz) {
+    if (group < 0 || group >= Inputs::max_update_groups || !(rateHz >= 0)) {
+        qWarning() << "SDL Controller API: Invalid rate" << rateHz << "for update group" << group;
+        return false;
+    }
+    if (rateHz > m_intervalHz) {
+        qWarning() << "SDL Controller API: Update group" << group << "at" << rateHz << "Hz is limited by the" << m_intervalHz << "Hz polling rate";
+    }
+    SdlController.setGroupRate(group, rateHz);
+    return true;
+}
+
+QVariantMap QmlControllerApi::outputStats() const {
+    return m_interpolator.running() ? rateStatsMap(m_interpolator.stats()) : QVariantMap();
+}
+
 QVariantList QmlControllerApi::channelValues() const {
     QVariantList list;
-    for (const auto& val : m_channels) {
+    for (const auto& val : m_ui_channels) {
         list.append(QVariant::fromValue(val));  // assuming ChannelDataType can be converted to QVariant
     }
     return list;
 }
 
+QVariantList QmlControllerApi::channelMinValues() const {
+    QVariantList list;
+    for (const auto& val : m_ui_min) {
+        list.append(QVariant::fromValue(val));
+    }
+    return list;
+}
+
+QVariantList QmlControllerApi::channelMaxValues() const {
+    QVariantList list;
+    for (const auto& val : m_ui_max) {
+        list.append(QVariant::fromValue(val));
+    }
+    return list;
+}
+
+void QmlControllerApi::enableHistory(double seconds) {
+    if (!(seconds > 0)) {
+        qWarning() << "SDL Controller API: Invalid history length:" << seconds;
+        return;
+    }
+    auto frames = static_cast<std::size_t>(seconds * m_intervalHz);
+    m_history = std::make_unique<ChannelHistory>(static_cast<int>(m_channels.size()), frames);
+    SdlController.setHistory(m_history.get());
+}
+
+void QmlControllerApi::disableHistory() {
+    SdlController.setHistory(nullptr);
+    m_history.reset();
+}
+
+void QmlControllerApi::enableOutputInterpolation(double rateHz) {
+    if (!(rateHz > 0)) {
+        qWarning() << "SDL Controller API: Invalid output rate:" << rateHz;
+        return;
+    }
+    m_interpolator.start(rateHz, [this](const std::vector<ChannelDataType> &frame) {
+        m_outputs.publish(frame);
+    });
+}
+
+void QmlControllerApi::disableOutputInterpolation() {
+    m_interpolator.stop();
+}
+
+bool QmlControllerApi::setChannelInterpolation(int channelIndex, int mode, double slewRate) {
+    if (channelIndex < 0 || channelIndex >= m_interpolator.channels() || mode < 0 || mode >= static_cast<int>(InterpolationMode::SIZE) || !(slewRate > 0)) {
+        qWarning() << "SDL Controller API: Invalid interpolation for channel" << channelIndex << "mode" << mode << "slew rate" << slewRate;
+        return false;
+    }
+    m_interpolator.setMode(channelIndex, static_cast<InterpolationMode>(mode));
+    m_interpolator.setSlewRate(channelIndex, slewRate);
+    return true;
+}
+
+QVariantMap QmlControllerApi::channelTrace(int channelIndex, int width, double seconds) const {
+    QVariantMap trace;
+    if (!m_history || width <= 0 || channelIndex < 0 || channelIndex >= m_history->channels()) {
+        return trace;
+    }
+    m_trace_min.resize(width);
+    m_trace_max.resize(width);
+    auto n_samples = static_cast<std::size_t>(std::max(seconds, 0.0) * m_intervalHz);
+    std::size_t first_valid = m_history->decimate(channelIndex, n_samples, width, m_trace_min.data(), m_trace_max.data());
+
+    QVariantList min;
+    QVariantList max;
+    min.reserve(width);
+    max.reserve(width);
+    for (int i = 0; i < width; ++i) {
+        min.append(m_trace_min[i]);
+        max.append(m_trace_max[i]);
+    }
+    trace["min"] = min;
+    trace["max"] = max;
+    trace["firstValid"] = static_cast<int>(first_valid);
+    return trace;
+}
+
 QString QmlControllerApi::getInput(int channelIndex) {
     ChannelConfig& channel = m_channel_config[channelIndex];
     scanning = true;
 
-    bool wasPolling = m_timer.isActive();
-    if (wasPolling) m_timer.stop();
+    bool wasPolling = m_polling;
+    if (wasPolling) stopPolling();
 
     QString label = "";
 
+    // Inputs pressed during the scan and still held. The first one released (or an axis moved) is the trigger,
+    // the others become its modifiers: hold a shoulder button, press A, let go of A for a "shoulder + A" chord.
+    std::vector<std::pair<ChannelConfig::InputVariant, SDL_Event>> held;
+    auto press = [&held](const ChannelConfig::InputVariant& input, const SDL_Event& event) {
+        for (const auto& [pressed, pressEvent] : held)
+            if (pressed == input) return;
+        held.emplace_back(input, event);
+    };
+    auto capture = [&](const ChannelConfig::InputVariant& input, const SDL_Event& event) {
+        scanning = false;
+        channel.raw_event = event;
+        channel.input_data = input;
+        channel.type = inputTypeOf(input);
+        channel.mode = channel.type == InputType::JoystickAxis ? ChannelModes::RAW : ChannelModes::HOLD;
+        channel.modifiers.clear();
+        for (const auto& [pressed, pressEvent] : held)
+            if (!(pressed == input)) channel.modifiers.push_back(pressed);
+
+        label = inputLabelFromChannel(channel);
+    };
+    auto release = [&](const ChannelConfig::InputVariant& input) {
+        for (const auto& [pressed, pressEvent] : held) {
+            if (pressed == input) {
+                capture(pressed, pressEvent);
+                return;
+            }
+        }
+    };
+
+    // Drop whatever was queued before the scan started, then only drain: a routed queue fills while we sleep
+    SdlController.flushEvents();
     SDL_Event event;
     while (scanning) {
-        SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_KEYDOWN) {
-                scanning = false;
-                channel.type = InputType::Keyboard;
-                channel.raw_event = event;
-                channel.input_data = event.key.keysym.sym;
-                channel.mode = ChannelModes::HOLD;
-
-                label =  inputLabelFromChannel(channel);
-                break;
+        while (scanning && SdlController.pollEvent(event)) {
+            if (event.type == SDL_KEYDOWN && !event.key.repeat) {
+                press(event.key.keysym.sym, event);
+            }
+            else if (event.type == SDL_KEYUP) {
+                release(event.key.keysym.sym);
             }
             else if (event.type == SDL_JOYBUTTONDOWN) {
-                scanning = false;
-                channel.type = InputType::JoystickButton;
-                channel.raw_event = event;
-                channel.input_data = JoystickButton{ event.jbutton.button, event.jbutton.which };
-                channel.mode = ChannelModes::HOLD;
-
-                label =  inputLabelFromChannel(channel);
-                break;
+                press(JoystickButton{ event.jbutton.button, event.jbutton.which, false }, event);
+            }
+            else if (event.type == SDL_JOYBUTTONUP) {
+                release(JoystickButton{ event.jbutton.button, event.jbutton.which, false });
+            }
+            // SDL game controllers send every input as a joystick event too, that one is bound. Devices opened by a
+            // backend (evdev) report their sticks and gamepad buttons only as controller events.
+            else if (event.type == SDL_CONTROLLERBUTTONDOWN && event.cbutton.which >= backend_device_ids) {
+                press(JoystickButton{ event.cbutton.button, event.cbutton.which, true }, event);
+            }
+            else if (event.type == SDL_CONTROLLERBUTTONUP && event.cbutton.which >= backend_device_ids) {
+                release(JoystickButton{ event.cbutton.button, event.cbutton.which, true });
+            }
+            else if (event.type == SDL_CONTROLLERAXISMOTION && event.caxis.which >= backend_device_ids && std::abs(event.caxis.value) > 16000) {
+                channel.offset = event.caxis.value;
+                capture(JoystickAxis{ event.caxis.axis, event.caxis.which, true }, event);
+            }
+            else if (event.type == SDL_JOYHATMOTION) {
+                // A held direction that is no longer reported was released
+                for (const auto& [pressed, pressEvent] : held) {
+                    if (!std::holds_alternative<JoystickHat>(pressed)) continue;
+                    JoystickHat hat = std::get<JoystickHat>(pressed);
+                    if (hat.hat == event.jhat.hat && hat.joystick_id == event.jhat.which && !(event.jhat.value & hat.direction)) {
+                        capture(pressed, pressEvent);
+                        break;
+                    }
+                }
+                if (scanning && event.jhat.value != SDL_HAT_CENTERED) {
+                    // Bind a single direction, diagonals resolve to their vertical component
+                    Uint8 direction = event.jhat.value & SDL_HAT_UP ? SDL_HAT_UP : event.jhat.value & SDL_HAT_DOWN ? SDL_HAT_DOWN : event.jhat.value & SDL_HAT_RIGHT ? SDL_HAT_RIGHT : SDL_HAT_LEFT;
+                    press(JoystickHat{ event.jhat.hat, direction, event.jhat.which }, event);
+                }
             }
             else if (event.type == SDL_JOYAXISMOTION && std::abs(event.jaxis.value) > 16000) {
-                scanning = false;
-                channel.type = InputType::JoystickAxis;
-                channel.raw_event = event;
-                channel.input_data = JoystickAxis{ event.jaxis.axis, event.jaxis.which };
                 channel.offset = event.jaxis.value;
-                channel.mode = ChannelModes::RAW;
-
-                label = inputLabelFromChannel(channel);
-                break;
+                capture(JoystickAxis{ event.jaxis.axis, event.jaxis.which, false }, event);
             }
         }
         SDL_Delay(10);
@@ -145,29 +550,72 @@ int QmlControllerApi::getChannelOffset(int channelIndex) const {
     return m_channel_config[channelIndex].offset;
 }
 
+bool QmlControllerApi::isAxisInput(int channelIndex) const {
+    if (channelIndex < 0 || channelIndex >= static_cast<int>(m_channel_config.size()))
+        return false;
+    return m_channel_config[channelIndex].type == InputType::JoystickAxis;
+}
+
+// Modes the ApplyInputChannel switches have a behavior for
+bool QmlControllerApi::modeSupported(InputType type, ChannelModes mode) {
+    switch (mode) {
+        case ChannelModes::RAW:
+            return type == InputType::Keyboard || type == InputType::JoystickAxis || type == InputType::None;
+        case ChannelModes::REPEAT:
+        case ChannelModes::DOUBLE_TAP:
+        case ChannelModes::LONG_PRESS:
+            return type != InputType::JoystickAxis;
+        default:
+            return true;
+    }
+}
+
+InputType QmlControllerApi::inputTypeOf(const ChannelConfig::InputVariant &input) {
+    if (std::holds_alternative<SDL_Keycode>(input)) return InputType::Keyboard;
+    if (std::holds_alternative<JoystickButton>(input)) return InputType::JoystickButton;
+    if (std::holds_alternative<JoystickAxis>(input)) return InputType::JoystickAxis;
+    if (std::holds_alternative<JoystickHat>(input)) return InputType::JoystickHat;
+    return InputType::None;
+}
+
 QString QmlControllerApi::inputLabelFromChannel(const ChannelConfig &channel) const {
-    switch (channel.type) {
+    QString label = inputLabel(channel.type, channel.input_data);
+    for (auto modifier = channel.modifiers.rbegin(); modifier != channel.modifiers.rend(); ++modifier)
+        label = inputLabel(inputTypeOf(*modifier), *modifier) + " + " + label;
+    return label;
+}
+
+QString QmlControllerApi::inputLabel(InputType type, const ChannelConfig::InputVariant &input) const {
+    switch (type) {
         case InputType::Keyboard:
-            if (std::holds_alternative<SDL_Keycode>(channel.input_data)) {
-                SDL_Keycode key = std::get<SDL_Keycode>(channel.input_data);
+            if (std::holds_alternative<SDL_Keycode>(input)) {
+                SDL_Keycode key = std::get<SDL_Keycode>(input);
                 return QString(SDL_GetKeyName(key));
             }
             return QString("Unknown Key");
 
         case InputType::JoystickButton:
-            if (std::holds_alternative<JoystickButton>(channel.input_data)) {
-                JoystickButton btn = std::get<JoystickButton>(channel.input_data);
-                return QString("Joystick %1 Button %2").arg(btn.joystick_id).arg(btn.button);
+            if (std::holds_alternative<JoystickButton>(input)) {
+                JoystickButton btn = std::get<JoystickButton>(input);
+                return QString("%1 %2 Button %3").arg(btn.controller ? "Controller" : "Joystick").arg(btn.joystick_id).arg(btn.button);
             }
             return QString("Unknown Joystick Button");
 
         case InputType::JoystickAxis:
-            if (std::holds_alternative<JoystickAxis>(channel.input_data)) {
-                JoystickAxis axis = std::get<JoystickAxis>(channel.input_data);
-                return QString("Joystick %1 Axis %2").arg(axis.joystick_id).arg(axis.axis);
+            if (std::holds_alternative<JoystickAxis>(input)) {
+                JoystickAxis axis = std::get<JoystickAxis>(input);
+                return QString("%1 %2 Axis %3").arg(axis.controller ? "Controller" : "Joystick").arg(axis.joystick_id).arg(axis.axis);
             }
             return QString("Unknown Joystick Axis");
 
+        case InputType::JoystickHat:
+            if (std::holds_alternative<JoystickHat>(input)) {
+                JoystickHat hat = std::get<JoystickHat>(input);
+                const char *direction = hat.direction == SDL_HAT_UP ? "Up" : hat.direction == SDL_HAT_DOWN ? "Down" : hat.direction == SDL_HAT_LEFT ? "Left" : "Right";
+                return QString("Joystick %1 Hat %2 %3").arg(hat.joystick_id).arg(hat.hat).arg(direction);
+            }
+            return QString("Unknown Joystick Hat");
+
         case InputType::None:
         default:
             return QString("");
@@ -181,6 +629,10 @@ bool QmlControllerApi::ApplyChannelSettings(int channelIndex, int mode, int offs
     }
 
     ChannelConfig& channel = m_channel_config[channelIndex];
+    if (!modeSupported(channel.type, static_cast<ChannelModes>(mode))) {
+        qWarning() << "SDL Controller API: Mode" << mode << "is not supported for the input of channel" << channelIndex;
+        return false;
+    }
 
     channel.mode = static_cast<ChannelModes>(mode);
     channel.offset = offset;
@@ -203,6 +655,7 @@ bool QmlControllerApi::ClearChannelConfig(int channelIndex) {
     channel.type = InputType::None;
     channel.raw_event = SDL_Event();        // default SDL_Event
     channel.input_data = ChannelConfig::InputVariant{}; // reset std::variant
+    channel.modifiers.clear();
     channel.offset = 0;
     channel.mode = ChannelModes::NONE;
 
@@ -221,10 +674,33 @@ bool QmlControllerApi::ApplyInputChannel(int channelIndex) {
     }
 
     const ChannelConfig& config = m_channel_config[channelIndex];
+    // Loaded configs may still carry a mode the input can't do, the channel is then left unbound
+    bool supported = modeSupported(config.type, config.mode);
+    if (!supported) {
+        qWarning() << "SDL Controller API: Mode" << static_cast<int>(config.mode) << "is not supported for the input of channel" << channelIndex;
+    }
     std::cout << "SDL Controller API: Applying config to channel " << channelIndex << ": "
               << "Type=" << static_cast<int>(config.type) << ", "
               << "Mode=" << static_cast<int>(config.mode) << ", "
               << "Offset=" << config.offset << ", ";
+    // The channel's behaviors reach the polling loop together, in one published snapshot
+    SdlController.beginEdit();
+
+    // Chords: behaviors added for this channel only apply while its modifiers are held
+    std::uint64_t modifiers = 0;
+    for (const auto& modifier : config.modifiers) {
+        if (std::holds_alternative<SDL_Keycode>(modifier)) {
+            modifiers |= SdlController.modifier(std::get<SDL_Keycode>(modifier));
+        } else if (std::holds_alternative<JoystickButton>(modifier)) {
+            auto jb = std::get<JoystickButton>(modifier);
+            modifiers |= SdlController.modifier(jb.button, jb.joystick_id, jb.controller ? InputSource::controller : InputSource::joystick);
+        } else if (std::holds_alternative<JoystickHat>(modifier)) {
+            auto jh = std::get<JoystickHat>(modifier);
+            modifiers |= SdlController.modifier(Inputs::hatButton(jh.hat, jh.direction), jh.joystick_id, InputSource::hat);
+        }
+    }
+    SdlController.setBindingModifiers(modifiers);
+
     // Apply input using Inputs methods
     switch (config.type) {
         case InputType::Keyboard: {
@@ -238,47 +714,134 @@ bool QmlControllerApi::ApplyInputChannel(int channelIndex) {
                 case ChannelModes::INCREMENT:     SdlController.addIncrement(config.channel, key, config.offset); break;
                 case ChannelModes::TOGGLE:        SdlController.addToggle(config.channel, key, config.offset); break;
                 case ChannelModes::TOGGLE_SYMETRIC:SdlController.addToggleSymmetric(config.channel, key, config.offset); break;
+                case ChannelModes::REPEAT:        SdlController.addRepeat(config.channel, key, config.offset); break;
+                case ChannelModes::DOUBLE_TAP:    SdlController.addDoubleTap(config.channel, key, config.offset); break;
+                case ChannelModes::LONG_PRESS:    SdlController.addLongPress(config.channel, key, config.offset); break;
                 default: break;
             }
             break;
         }
         case InputType::JoystickButton: {
             auto jb = std::get<JoystickButton>(config.input_data);
+            InputSource source = jb.controller ? InputSource::controller : InputSource::joystick;
             std::cout << "Button= " << static_cast<int>(jb.button) << " on Joystick " << jb.joystick_id << std::endl;
             switch (config.mode) {
-                case ChannelModes::TAP:           SdlController.addTap(config.channel, jb.button, jb.joystick_id, config.offset); break;
-                case ChannelModes::HOLD:          SdlController.addHold(config.channel, jb.button, jb.joystick_id, config.offset); break;
-                case ChannelModes::RELEASE:       SdlController.addRelease(config.channel, jb.button, jb.joystick_id, config.offset); break;
-                case ChannelModes::INCREMENT:     SdlController.addIncrement(config.channel, jb.button, jb.joystick_id, config.offset); break;
-                case ChannelModes::TOGGLE:        SdlController.addToggle(config.channel, jb.button, jb.joystick_id, config.offset); break;
-                case ChannelModes::TOGGLE_SYMETRIC:SdlController.addToggleSymmetric(config.channel, jb.button, jb.joystick_id, config.offset); break;
+                case ChannelModes::TAP:           SdlController.addTap(config.channel, jb.button, jb.joystick_id, config.offset, source); break;
+                case ChannelModes::HOLD:          SdlController.addHold(config.channel, jb.button, jb.joystick_id, config.offset, source); break;
+                case ChannelModes::RELEASE:       SdlController.addRelease(config.channel, jb.button, jb.joystick_id, config.offset, source); break;
+                case ChannelModes::INCREMENT:     SdlController.addIncrement(config.channel, jb.button, jb.joystick_id, config.offset, source); break;
+                case ChannelModes::TOGGLE:        SdlController.addToggle(config.channel, jb.button, jb.joystick_id, config.offset, source); break;
+                case ChannelModes::TOGGLE_SYMETRIC:SdlController.addToggleSymmetric(config.channel, jb.button, jb.joystick_id, config.offset, source); break;
+                case ChannelModes::REPEAT:        SdlController.addRepeat(config.channel, jb.button, jb.joystick_id, config.offset, InputMode::increment, source); break;
+                case ChannelModes::DOUBLE_TAP:    SdlController.addDoubleTap(config.channel, jb.button, jb.joystick_id, config.offset, InputMode::toggle, source); break;
+                case ChannelModes::LONG_PRESS:    SdlController.addLongPress(config.channel, jb.button, jb.joystick_id, config.offset, InputMode::toggle, source); break;
                 default: break;
             }
             break;
         }
         case InputType::JoystickAxis: {
             auto ja = std::get<JoystickAxis>(config.input_data);
+            InputSource source = ja.controller ? InputSource::controller : InputSource::joystick;
             std::cout << "Axis= " << static_cast<int>(ja.axis) << " on Joystick " << ja.joystick_id << std::endl;
             switch (config.mode) {
-                case ChannelModes::RAW:           SdlController.addAxis(config.channel, ja.axis, ja.joystick_id, config.offset); break;
-                case ChannelModes::TAP:           SdlController.addAxisTap(config.channel, ja.axis, ja.joystick_id, config.offset); break;
-                case ChannelModes::HOLD:          SdlController.addAxisHold(config.channel, ja.axis, ja.joystick_id, config.offset); break;
-                case ChannelModes::RELEASE:       SdlController.addAxisRelease(config.channel, ja.axis, ja.joystick_id, config.offset); break;
-                case ChannelModes::INCREMENT:     SdlController.addAxisIncrement(config.channel, ja.axis, ja.joystick_id, config.offset); break;
-                case ChannelModes::TOGGLE:        SdlController.addAxisToggle(config.channel, ja.axis, ja.joystick_id, config.offset); break;
-                case ChannelModes::TOGGLE_SYMETRIC:SdlController.addAxisToggleSymmetric(config.channel, ja.axis, ja.joystick_id, config.offset); break;
+                case ChannelModes::RAW:           SdlController.addAxis(config.channel, ja.axis, ja.joystick_id, config.offset, AxisAsButton::no, 0, InputMode::set, source); break;
+                case ChannelModes::TAP:           SdlController.addAxisTap(config.channel, ja.axis, ja.joystick_id, config.offset, 0, source); break;
+                case ChannelModes::HOLD:          SdlController.addAxisHold(config.channel, ja.axis, ja.joystick_id, config.offset, 0, source); break;
+                case ChannelModes::RELEASE:       SdlController.addAxisRelease(config.channel, ja.axis, ja.joystick_id, config.offset, 0, source); break;
+                case ChannelModes::INCREMENT:     SdlController.addAxisIncrement(config.channel, ja.axis, ja.joystick_id, config.offset, 0, source); break;
+                case ChannelModes::TOGGLE:        SdlController.addAxisToggle(config.channel, ja.axis, ja.joystick_id, config.offset, 0, source); break;
+                case ChannelModes::TOGGLE_SYMETRIC:SdlController.addAxisToggleSymmetric(config.channel, ja.axis, ja.joystick_id, config.offset, 0, source); break;
+                default: break;
+            }
+            break;
+        }
+        case InputType::JoystickHat: {
+            auto jh = std::get<JoystickHat>(config.input_data);
+            Uint8 button = Inputs::hatButton(jh.hat, jh.direction);
+            std::cout << "Hat= " << static_cast<int>(jh.hat) << " Direction= " << static_cast<int>(jh.direction) << " on Joystick " << jh.joystick_id << std::endl;
+            switch (config.mode) {
+                case ChannelModes::TAP:           SdlController.addTap(config.channel, button, jh.joystick_id, config.offset, InputSource::hat); break;
+                case ChannelModes::HOLD:          SdlController.addHold(config.channel, button, jh.joystick_id, config.offset, InputSource::hat); break;
+                case ChannelModes::RELEASE:       SdlController.addRelease(config.channel, button, jh.joystick_id, config.offset, InputSource::hat); break;
+                case ChannelModes::INCREMENT:     SdlController.addIncrement(config.channel, button, jh.joystick_id, config.offset, InputSource::hat); break;
+                case ChannelModes::TOGGLE:        SdlController.addToggle(config.channel, button, jh.joystick_id, config.offset, InputSource::hat); break;
+                case ChannelModes::TOGGLE_SYMETRIC:SdlController.addToggleSymmetric(config.channel, button, jh.joystick_id, config.offset, InputSource::hat); break;
+                case ChannelModes::REPEAT:        SdlController.addRepeat(config.channel, button, jh.joystick_id, config.offset, InputMode::increment, InputSource::hat); break;
+                case ChannelModes::DOUBLE_TAP:    SdlController.addDoubleTap(config.channel, button, jh.joystick_id, config.offset, InputMode::toggle, InputSource::hat); break;
+                case ChannelModes::LONG_PRESS:    SdlController.addLongPress(config.channel, button, jh.joystick_id, config.offset, InputMode::toggle, InputSource::hat); break;
                 default: break;
             }
             break;
         }
         case InputType::None: // Reset channel to defaults
             m_channels[channelIndex] = default_channel_value;
+            m_ui_channels[channelIndex] = default_channel_value;
             SdlController.clear(channelIndex);
         default:
             break;
     }
+    SdlController.setBindingModifiers(0);
+    SdlController.commitEdit();
 
+    refreshWatchedDevices();
     emit channelValuesChanged(); // notify QML
+    return supported;
+}
+
+void QmlControllerApi::refreshWatchedDevices() {
+    // Saved ids are instance ids of the session that bound them. The watchdog only counts the ones that are open or
+    // being opened, a stale id or an absent device never holds failsafe.
+    std::vector<SDL_JoystickID> devices;
+    for (const ChannelConfig &config : m_channel_config) {
+        if (std::holds_alternative<JoystickButton>(config.input_data)) {
+            devices.push_back(std::get<JoystickButton>(config.input_data).joystick_id);
+        } else if (std::holds_alternative<JoystickAxis>(config.input_data)) {
+            devices.push_back(std::get<JoystickAxis>(config.input_data).joystick_id);
+        } else if (std::holds_alternative<JoystickHat>(config.input_data)) {
+            devices.push_back(std::get<JoystickHat>(config.input_data).joystick_id);
+        }
+    }
+    m_watchdog.setWatchedDevices(devices);
+}
+
+QVariantMap QmlControllerApi::watchdogCounters() const {
+    WatchdogCounters counters = m_watchdog.counters();
+    QVariantMap map;
+    map["cycles"] = static_cast<qulonglong>(counters.cycles);
+    map["overruns"] = static_cast<qulonglong>(counters.overruns);
+    map["failsafeEntries"] = static_cast<qulonglong>(counters.failsafe_entries);
+    map["deviceLosses"] = static_cast<qulonglong>(counters.device_losses);
+    map["lastJitterUs"] = static_cast<qlonglong>(counters.last_jitter_us);
+    map["maxJitterUs"] = static_cast<qlonglong>(counters.max_jitter_us);
+    map["failsafe"] = counters.failsafe;
+    return map;
+}
+
+bool QmlControllerApi::setFailsafe(int channelIndex, int mode, int preset) {
+    if (channelIndex < 0 || channelIndex >= static_cast<int>(m_channel_config.size())) {
+        qWarning() << "SDL Controller API: Invalid channel index:" << channelIndex;
+        return false;
+    }
+    if (mode < 0 || mode >= static_cast<int>(FailsafeMode::SIZE)) {
+        qWarning() << "SDL Controller API: Invalid failsafe mode:" << mode;
+        return false;
+    }
+    m_watchdog.setFailsafe(channelIndex, static_cast<FailsafeMode>(mode), preset);
+    return true;
+}
+
+bool QmlControllerApi::setWatchdogThresholds(double overrunTolerance, int overrunsToTrip, int deviceTimeoutMs, int recoveryCycles) {
+    if (!(overrunTolerance >= 0) || overrunsToTrip < 0 || deviceTimeoutMs < 0 || recoveryCycles < 0) {
+        qWarning() << "SDL Controller API: Invalid watchdog thresholds: tolerance" << overrunTolerance << "overruns" << overrunsToTrip
+                   << "device timeout" << deviceTimeoutMs << "ms recovery cycles" << recoveryCycles;
+        return false;
+    }
+    WatchdogConfig config = m_watchdog.getConfig();
+    config.overrun_tolerance = overrunTolerance;
+    config.overruns_to_trip = overrunsToTrip;
+    config.device_timeout = std::chrono::milliseconds(deviceTimeoutMs);
+    config.recovery_cycles = recoveryCycles;
+    m_watchdog.setConfig(config);
     return true;
 }
 
@@ -299,45 +862,120 @@ void QmlControllerApi::injectKey(int qtKey, const QString& text) {
     SDL_PushEvent(&sdlEvent);
 }
 
-bool QmlControllerApi::saveConfig(const QString& filePath) {
-    if (filePath.isEmpty()) {
-        // No path given → save to default app folder
-        return saveChannelConfigs(SDL_CONFIG_FILE_NAME ,m_channel_config);
-    } else {
-        return saveChannelConfigs(filePath, m_channel_config);
-    }
-
-    std::cout << "SDL Controller API: Config saved to " << (filePath.isEmpty() ? "default path" : filePath.toStdString()) << std::endl;
+void QmlControllerApi::saveConfig(const QString& filePath) {
+    // No path given → save to default app folder
+    m_config_path = filePath.isEmpty() ? QString(SDL_CONFIG_FILE_NAME) : filePath;
+    QByteArray data = channelConfigsToJson(m_channel_config);
+    m_config_json = data;
+    ++m_pending_saves;
+
+    // Written to a temporary file and renamed over the old one on the IO thread, the GUI thread never waits on disk
+    QString path = m_config_path;
+    m_config_io.start([this, path, data] {
+        bool success = writeConfigFile(path, data);
+        QMetaObject::invokeMethod(this, [this, path, success] {
+            --m_pending_saves;
+            if (success) {
+                std::cout << "SDL Controller API: Config saved to " << path.toStdString() << std::endl;
+            } else {
+                qWarning() << "SDL Controller API: Could not save config to" << path;
+            }
+            watchConfigFile();
+            emit configSaved(success);
+        }, Qt::QueuedConnection);
+    });
 }
 
 bool QmlControllerApi::loadConfig(const QString& filePath) {
-    bool success;
-    if (filePath.isEmpty()) {
-        // No path given → load from default app folder
-        success = loadChannelConfigs(SDL_CONFIG_FILE_NAME, m_channel_config);
-    } else {
-        success = loadChannelConfigs(filePath, m_channel_config);
-    }
+    // No path given → load from default app folder
+    m_config_path = filePath.isEmpty() ? QString(SDL_CONFIG_FILE_NAME) : filePath;
+    watchConfigFile();
+
+    QFile file(m_config_path);
+    QByteArray data;
+    std::vector<ChannelConfig> configs;
+    bool success = file.open(QIODevice::ReadOnly) && parseChannelConfigs(data = file.readAll(), configs);
     // Check if load was succesfull
     if (!success) { 
-        std::cout << "SDL Controller API: Config not found at (" << SDL_CONFIG_FILE_NAME << ")" << std::endl; 
+        std::cout << "SDL Controller API: Config not found at (" << m_config_path.toStdString() << ")" << std::endl; 
         return success; 
     }    
 
-    // Re-apply all channel configs
+    m_config_json = data;
+    int n_changed = applyChannelConfigs(std::move(configs));
+    emit configLoaded();
+    emit channelValuesChanged();
+    std::cout << "SDL Controller API: Config loaded from " << m_config_path.toStdString() << ", " << n_changed << " channels changed" << std::endl;
+    return success;
+}
+
+int QmlControllerApi::applyChannelConfigs(std::vector<ChannelConfig> configs) {
+    // Channels whose entry did not change keep their behaviors and current value
+    int n_changed = 0;
+    SdlController.beginEdit();
     for (size_t i = 0; i < m_channel_config.size(); ++i) {
-        if (m_channel_config[i].type == InputType::None) continue;
+        ChannelConfig config = i < configs.size() ? std::move(configs[i]) : ChannelConfig{};
+        config.channel = static_cast<int>(i);
+        if (sameChannelConfig(config, m_channel_config[i])) continue;
+
+        m_channel_config[i] = std::move(config);
         SdlController.clear(static_cast<int>(i));
         m_channels[i] = default_channel_value;
+        m_ui_channels[i] = default_channel_value;
         ApplyInputChannel(static_cast<int>(i));
+        ++n_changed;
     }
-    
-    if (success) {
-        emit configLoaded();
-        emit channelValuesChanged();
-        std::cout << "SDL Controller API: Config loaded from " << (filePath.isEmpty() ? "default path" : filePath.toStdString()) << std::endl;
+    SdlController.commitEdit();
+    return n_changed;
+}
+
+void QmlControllerApi::watchConfigFile() {
+    // Renaming a new file over the old one ends the watch on it, so the path is watched again after every change.
+    // The folder is watched too, to see the file come back when an editor deletes and recreates it.
+    if (!m_config_watcher.files().isEmpty()) {
+        m_config_watcher.removePaths(m_config_watcher.files());
     }
-    return success;
+    if (!m_config_watcher.directories().isEmpty()) {
+        m_config_watcher.removePaths(m_config_watcher.directories());
+    }
+    QFileInfo info(m_config_path);
+    m_config_watcher.addPath(info.absolutePath());
+    if (info.exists()) {
+        m_config_watcher.addPath(info.absoluteFilePath());
+    }
+}
+
+void QmlControllerApi::reloadConfigFile() {
+    watchConfigFile();
+    if (m_pending_saves > 0) {
+        return; // Our own save, the file will match the live config
+    }
+
+    QString path = m_config_path;
+    m_config_io.start([this, path] {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+        QByteArray data = file.readAll();
+        QMetaObject::invokeMethod(this, [this, path, data] {
+            if (path != m_config_path || m_pending_saves > 0 || data == m_config_json) {
+                return;
+            }
+            std::vector<ChannelConfig> configs;
+            if (!parseChannelConfigs(data, configs)) {
+                qWarning() << "SDL Controller API: Ignoring unreadable config change in" << path;
+                return;
+            }
+            m_config_json = data;
+            int n_changed = applyChannelConfigs(std::move(configs));
+            std::cout << "SDL Controller API: Config reloaded from " << path.toStdString() << ", " << n_changed << " channels changed" << std::endl;
+            if (n_changed > 0) {
+                emit configLoaded();
+                emit channelValuesChanged();
+            }
+        }, Qt::QueuedConnection);
+    });
 }
 
 // DEBUGGING
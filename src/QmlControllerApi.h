@@ -5,13 +5,25 @@
 #include <iostream>
 #include <QObject>
 #include <QTimer>
+#include <QThreadPool>
+#include <QFileSystemWatcher>
+#include <QByteArray>
 #include <QVariant>
+#include <QVariantMap>
 #include <functional>
+#include <chrono>
+#include <memory>
 #include <QCoreApplication>
 #include <SDL2/SDL_keycode.h> // Seems to work for Arch Linux, not sure if it also works for Windows
 
 
 #include "inputController.h"
+#include "watchdog.h"
+#include "rateScheduler.h"
+#include "outputFanout.h"
+#include "outputInterpolator.h"
+#include "startupTimeline.h"
+#include "traceRecorder.h"
 #include "ChannelConfig.h"
 
 
@@ -21,18 +33,39 @@
 class QmlControllerApi : public QObject {
     Q_OBJECT
     Q_PROPERTY(QVariantList channelValues READ channelValues NOTIFY channelValuesChanged)
+    Q_PROPERTY(QVariantList channelMinValues READ channelMinValues NOTIFY channelValuesChanged)
+    Q_PROPERTY(QVariantList channelMaxValues READ channelMaxValues NOTIFY channelValuesChanged)
+    Q_PROPERTY(double uiRefreshRate READ uiRefreshRate WRITE setUiRefreshRate NOTIFY uiRefreshRateChanged)
+    Q_PROPERTY(bool failsafeActive READ failsafeActive NOTIFY failsafeActiveChanged)
+    Q_PROPERTY(QVariantMap watchdogCounters READ watchdogCounters NOTIFY watchdogCountersChanged)
+    Q_PROPERTY(QVariantMap stats READ statsSnapshot NOTIFY statsChanged)
 
 public:
     explicit QmlControllerApi(Inputs& controller, QObject *parent = nullptr);
     ~QmlControllerApi();
 
     // Polling functions
-    Q_INVOKABLE void startPolling(int intervalHz = 50);
-    Q_INVOKABLE void setPollingInterval(int intervalHz);
+    Q_INVOKABLE void startPolling(double intervalHz = 50);
+    Q_INVOKABLE void setPollingInterval(double intervalHz);
     Q_INVOKABLE void stopPolling();
+    Q_INVOKABLE QVariantMap pollingStats() const;
+    RateStats pollingRateStats() const { return m_clock.stats(); }
+
+    // Update groups: the channels of a group are published at the group's rate, 0 for every poll. Polling itself
+    // still handles every group each cycle.
+    // Sticks can stay at the polling rate while switches go out at a few Hz.
+    Q_INVOKABLE bool setChannelGroup(int channelIndex, int group);
+    Q_INVOKABLE bool setGroupRate(int group, double rateHz);
 
     // CHANNELS
+    // Published at the UI refresh rate: the latest frame plus the min/max of every frame since the previous publish
     QVariantList channelValues() const;
+    QVariantList channelMinValues() const;
+    QVariantList channelMaxValues() const;
+
+    // UI refresh rate in Hz, independent from the polling rate. 0 follows the primary screen's refresh rate.
+    double uiRefreshRate() const { return m_ui_rate_hz; }
+    Q_INVOKABLE void setUiRefreshRate(double rateHz);
     
     // Input Detection
     Q_INVOKABLE QString getInput(int channelIndex);
@@ -43,7 +76,9 @@ public:
     Q_INVOKABLE bool ClearChannelConfig(int channel_index);
 
     //  Save and Load config file
-    Q_INVOKABLE bool saveConfig(const QString& filePath = QString());
+    // Saves are written in the background (configSaved reports the result). The file is watched afterwards and
+    // external edits are reloaded, rebinding only the channels whose entry changed.
+    Q_INVOKABLE void saveConfig(const QString& filePath = QString());
     Q_INVOKABLE bool loadConfig(const QString& filePath = QString());
 
     // QML to SDL Injection
@@ -54,16 +89,67 @@ public:
     Q_INVOKABLE QString getChannelInputLabel(int index) const;
     Q_INVOKABLE int getMode(int channelIndex) const;
     Q_INVOKABLE int getChannelOffset(int channelIndex) const;
-
-    // Callback for sending channel outputs to other components
-    void setChannelsCallback(std::function<void(const std::vector<ChannelDataType>&)> cb) {
-        channels_callback = std::move(cb);
-    }
+    Q_INVOKABLE bool isAxisInput(int channelIndex) const;
+
+    // Watchdog: failsafe output on late cycles or lost devices
+    bool failsafeActive() const { return m_watchdog.inFailsafe(); }
+    QVariantMap watchdogCounters() const;
+    Q_INVOKABLE bool setFailsafe(int channelIndex, int mode, int preset = 0);
+    Q_INVOKABLE bool setWatchdogThresholds(double overrunTolerance, int overrunsToTrip, int deviceTimeoutMs, int recoveryCycles);
+    Q_INVOKABLE void resetWatchdogCounters() { m_watchdog.resetCounters(); emit watchdogCountersChanged(); }
+    Watchdog &watchdog() { return m_watchdog; }
+
+    // Performance counters of the input engine, polling loop and watchdog
+    Q_INVOKABLE QVariantMap statsSnapshot() const;
+    Q_INVOKABLE void resetStats();
+    InputStatsSnapshot inputStats() const { return SdlController.statsSnapshot(); }
+
+    // Channel history for scope plots, sized for the current polling rate
+    Q_INVOKABLE void enableHistory(double seconds);
+    Q_INVOKABLE void disableHistory();
+    Q_INVOKABLE QVariantMap channelTrace(int channelIndex, int width, double seconds) const;
+    const ChannelHistory *history() const { return m_history.get(); }
+
+    // Output stage: frames are published at rateHz from its own thread. Channels step unless setChannelInterpolation
+    // makes them ramp (linear) or slew, failsafe values always apply at once.
+    Q_INVOKABLE void enableOutputInterpolation(double rateHz);
+    Q_INVOKABLE void disableOutputInterpolation();
+    Q_INVOKABLE bool setChannelInterpolation(int channelIndex, int mode, double slewRate = 4000);
+    Q_INVOKABLE QVariantMap outputStats() const;
+    OutputInterpolator &interpolator() { return m_interpolator; }
+
+    // Output sinks: every sink runs on its own thread with its own queue, so a slow consumer never delays the
+    // polling loop or the other sinks
+    int addOutputSink(OutputFanout::Consumer consumer, SinkConfig config = {}) { return m_outputs.addSink(std::move(consumer), std::move(config)); }
+    bool removeOutputSink(int id) { return m_outputs.removeSink(id); }
+    Q_INVOKABLE QVariantList outputSinkStats() const;
+    OutputFanout &outputs() { return m_outputs; }
+
+    // Startup breakdown: the first frame and the moment every device is open are marked on the timeline,
+    // which is printed once both happened
+    void setStartupTimeline(StartupTimeline *timeline) { m_startup = timeline; m_startup_done = false; }
+    Q_INVOKABLE QVariantList startupTimings() const;
+
+    // Timeline of the polling loop phases, to find what the multi-millisecond spikes are made of.
+    // The saved file opens in chrome://tracing or the Perfetto UI.
+    Q_INVOKABLE void startTrace(int eventsPerThread = 65536);
+    Q_INVOKABLE void stopTrace();
+    Q_INVOKABLE bool saveTrace(const QString& filePath);
+
+    // Callback for sending channel outputs to other components. It runs on its own output sink thread, up to 64 frames
+    // queue up for it. A callback that falls further behind loses the oldest ones, counted as "dropped" of the
+    // "callback" sink in outputSinkStats(); polling never waits for it.
+    void setChannelsCallback(std::function<void(const std::vector<ChannelDataType>&)> cb);
 
     
 signals:
     void channelValuesChanged();
     void configLoaded();
+    void configSaved(bool success);
+    void failsafeActiveChanged();
+    void watchdogCountersChanged();
+    void statsChanged();
+    void uiRefreshRateChanged();
     
 private:
     // Library specific
@@ -73,17 +159,68 @@ private:
     int const default_channel_value = 1500; // Should be moved to next iteration on input library...
     std::vector<ChannelConfig> m_channel_config;
     bool ApplyInputChannel(int channelIndex);
+    int applyChannelConfigs(std::vector<ChannelConfig> configs);
+
+    // Config persistence
+    QString m_config_path = SDL_CONFIG_FILE_NAME;
+    QThreadPool m_config_io;                // a single thread, so saves land in order
+    QFileSystemWatcher m_config_watcher;
+    QTimer m_reload_timer;                  // debounces bursts of change notifications
+    QByteArray m_config_json;               // file content matching the live config
+    int m_pending_saves = 0;
+    void watchConfigFile();
+    void reloadConfigFile();
+
+    // Watchdog
+    Watchdog m_watchdog;
+    bool m_failsafe_active = false;
+    void refreshWatchedDevices();
     
     // Input Detection
     bool scanning = false;
-    int m_intervalHz = 50;
+    double m_intervalHz = 50;
+    bool m_polling = false;
     
     // QML specific
     QTimer m_timer;
+    DeadlineClock m_clock;
+    void pollTick();
+    DeadlineClock::Clock::time_point m_last_stats_emit{};
+    void scheduleNextPoll();
     QString inputLabelFromChannel(const ChannelConfig& channel) const;
-
-    // Callback
-    std::function<void(const std::vector<ChannelDataType>&)> channels_callback;
+    QString inputLabel(InputType type, const ChannelConfig::InputVariant& input) const;
+    static InputType inputTypeOf(const ChannelConfig::InputVariant& input);
+    static bool modeSupported(InputType type, ChannelModes mode);
+
+    // UI publishing
+    double m_ui_rate_hz = 0;
+    std::chrono::nanoseconds m_ui_period{0};
+    DeadlineClock::Clock::time_point m_next_ui_publish{};
+    bool m_ui_aggregate_empty = true;
+    std::vector<ChannelDataType> m_ui_channels;
+    std::vector<ChannelDataType> m_ui_min;
+    std::vector<ChannelDataType> m_ui_max;
+    std::vector<ChannelDataType> m_frame_min;
+    std::vector<ChannelDataType> m_frame_max;
+    void aggregateUiFrame();
+    void publishUiFrame();
+
+    // History
+    std::unique_ptr<ChannelHistory> m_history;
+    mutable std::vector<ChannelDataType> m_trace_min;
+    mutable std::vector<ChannelDataType> m_trace_max;
+
+    // Output interpolation
+    OutputInterpolator m_interpolator;
+
+    // Startup
+    StartupTimeline *m_startup = nullptr;
+    bool m_startup_done = false;
+    void markStartup();
+
+    // Output sinks
+    OutputFanout m_outputs;
+    int m_callback_sink = -1;
 
     // Debugging
     // Outputs channel values to console
@@ -0,0 +1,213 @@
+#define SDL_MAIN_HANDLED
+
+#include <QCoreApplication>
+#include <QTimer>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <SDL.h>
+
+#include "inputController.h"
+#include "loadGenerator.h"
+#include "traceRecorder.h"
+#include "../src/QmlControllerApi.h"
+
+// Drives virtual devices through a real Inputs, headless, and reports what made it through. Exits with 1 when a
+// --max-* limit is exceeded, so a CI job can gate on it.
+
+namespace {
+
+void usage() {
+    std::cout << "Usage: SDL_RC_LoadGenerator [options]\n"
+                 "  --devices N          virtual devices (1)\n"
+                 "  --type joystick|gamepad (gamepad)\n"
+                 "  --rate HZ            device updates per second (1000)\n"
+                 "  --wave sine|ramp|square|random (sine)\n"
+                 "  --wave-hz HZ         axis wave frequency (1)\n"
+                 "  --buttons HZ         button toggles per second and device (10)\n"
+                 "  --hats HZ            hat changes per second and device (2)\n"
+                 "  --script FILE        scripted pattern instead of the generated one\n"
+                 "  --hotplug HZ         detach and attach a device this often (0)\n"
+                 "  --seed N             random seed (1)\n"
+                 "  --poll HZ            Inputs cycles per second (1000)\n"
+                 "  --channels N         channels of Inputs (16)\n"
+                 "  --seconds S          run time (10)\n"
+                 "  --api                poll through QmlControllerApi instead of a plain loop\n"
+                 "  --trace FILE         save a Chrome trace of the run\n"
+                 "  --max-drop FRACTION  fail when more than this fraction of changes was dropped\n"
+                 "  --max-p99-us US      fail when the 99th latency percentile is above this\n";
+}
+
+void printStats(const LoadStats &stats, const InputStatsSnapshot &input_stats, const RateStats &polling) {
+    static const char *names[] = {"axis", "button", "hat"};
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Load over " << stats.seconds << " s, device updates at " << stats.rate.achieved_hz << " Hz ("
+              << stats.rate.missed << " missed), Inputs at " << polling.achieved_hz << " Hz (" << polling.missed << " missed)" << std::endl;
+    std::cout << " input  |       sent |   received |    dropped |  per second" << std::endl;
+    for (std::size_t i = 0; i < stats.sent.size(); ++i) {
+        std::cout << std::setw(7) << names[i] << " | " << std::setw(10) << stats.sent[i] << " | " << std::setw(10) << stats.received[i]
+                  << " | " << std::setw(10) << stats.dropped(static_cast<LoadInput>(i)) << " | "
+                  << std::setw(11) << (stats.seconds > 0 ? stats.received[i] / stats.seconds : 0) << std::endl;
+    }
+    std::cout << "Unmatched " << stats.unmatched << ", hot-plugs " << stats.hotplugs << std::endl;
+    std::cout << "Latency us p50 " << stats.latency_p50_us << ", p99 " << stats.latency_p99_us << ", max " << stats.latency_max_us
+              << " over " << stats.latency_samples << " events" << std::endl;
+    std::cout << "Cycle us min " << input_stats.cycle_min_us << ", avg " << input_stats.cycle_avg_us << ", max " << input_stats.cycle_max_us
+              << " over " << input_stats.cycles << " cycles, " << input_stats.behaviors_evaluated << " behaviors evaluated" << std::endl;
+    std::cout << std::defaultfloat;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    LoadProfile profile;
+    double poll_hz = 1000;
+    double seconds = 10;
+    int n_channels = 16;
+    bool use_api = false;
+    std::string trace_path;
+    double max_drop = -1;
+    double max_p99_us = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Invalid option " << option << ": missing value" << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (option == "--devices") profile.devices = std::stoi(value());
+        else if (option == "--type") profile.type = value() == "joystick" ? VirtualDeviceType::joystick : VirtualDeviceType::gamepad;
+        else if (option == "--rate") profile.update_hz = std::stod(value());
+        else if (option == "--wave") {
+            std::string wave = value();
+            profile.wave = wave == "ramp" ? WaveForm::ramp : wave == "square" ? WaveForm::square : wave == "random" ? WaveForm::random : WaveForm::sine;
+        }
+        else if (option == "--wave-hz") profile.wave_hz = std::stod(value());
+        else if (option == "--buttons") profile.button_hz = std::stod(value());
+        else if (option == "--hats") profile.hat_hz = std::stod(value());
+        else if (option == "--script") {
+            if (!loadScript(value(), profile.script)) {
+                return 2;
+            }
+        }
+        else if (option == "--hotplug") profile.hotplug_hz = std::stod(value());
+        else if (option == "--seed") profile.seed = static_cast<std::uint32_t>(std::stoul(value()));
+        else if (option == "--poll") poll_hz = std::stod(value());
+        else if (option == "--channels") n_channels = std::stoi(value());
+        else if (option == "--seconds") seconds = std::stod(value());
+        else if (option == "--api") use_api = true;
+        else if (option == "--trace") trace_path = value();
+        else if (option == "--max-drop") max_drop = std::stod(value());
+        else if (option == "--max-p99-us") max_p99_us = std::stod(value());
+        else {
+            usage();
+            return option == "--help" ? 0 : 2;
+        }
+    }
+
+    QCoreApplication app(argc, argv);
+
+    // No video subsystem, so no display is needed, and joystick events never wait for a focused window
+    SDL_SetHint(SDL_HINT_JOYSTICK_ALLOW_BACKGROUND_EVENTS, "1");
+    if (SDL_Init(SDL_INIT_EVENTS | SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER) != 0) {
+        std::cout << "SDL_InitSubSystem Error: " << SDL_GetError() << std::endl;
+        return 2;
+    }
+
+    // Attached before Inputs opens its devices, so it finds them like hardware plugged in at start up
+    LoadGenerator generator(profile);
+    if (!generator.attach()) {
+        SDL_Quit();
+        return 2;
+    }
+    if (!trace_path.empty()) {
+        TraceRecorder::start();
+    }
+
+    Inputs inputs(n_channels, DeviceOpening::eager);
+    SdlBackend sdl_backend;
+    LoadProbeBackend probe(sdl_backend, generator);
+    inputs.setBackend(&probe);
+
+    // Created before the bindings below, loading its saved config replaces whatever Inputs had
+    std::unique_ptr<QmlControllerApi> api;
+    if (use_api) {
+        api = std::make_unique<QmlControllerApi>(inputs);
+        api->setDebug(false);
+    }
+
+    // Every axis and button gets a channel, round robin, so each event runs a behavior. Devices that come back
+    // from a hot-plug have new ids and only feed the probe.
+    inputs.beginEdit();
+    std::vector<SDL_JoystickID> devices = generator.devices();
+    const LoadProfile &layout = generator.profile();
+    int next_channel = 0;
+    for (SDL_JoystickID which : devices) {
+        for (int axis = 0; axis < layout.axes; ++axis) {
+            inputs.addAxis(next_channel++ % n_channels, axis, which, 1, AxisAsButton::no, 0, InputMode::set, InputSource::joystick);
+        }
+        for (int button = 0; button < layout.buttons; ++button) {
+            inputs.addHold(next_channel++ % n_channels, button, which, 500, InputSource::joystick);
+        }
+    }
+    inputs.commitEdit();
+
+    generator.start();
+    RateStats polling;
+    if (api) {
+        api->startPolling(poll_hz);
+        QTimer::singleShot(static_cast<int>(seconds * 1000), &app, &QCoreApplication::quit);
+        app.exec();
+        polling = api->pollingRateStats();
+        api->stopPolling();
+    } else {
+        DeadlineClock clock(poll_hz);
+        auto end = InputClock::now() + std::chrono::duration_cast<InputClock::duration>(std::chrono::duration<double>(seconds));
+        while (InputClock::now() < end) {
+            RateScheduler::sleepUntil(clock.deadline());
+            clock.tick();
+            if (!inputs.cycle()) {
+                break;
+            }
+        }
+        polling = clock.stats();
+    }
+    generator.stop();
+
+    // Whatever is still queued counts as received, not as dropped
+    for (int i = 0; i < 10; ++i) {
+        inputs.cycle();
+    }
+    LoadStats stats = generator.stats();
+    printStats(stats, inputs.statsSnapshot(), polling);
+
+    if (!trace_path.empty()) {
+        TraceRecorder::stop();
+        TraceRecorder::saveChromeJson(trace_path);
+    }
+    api.reset();
+    inputs.setBackend(nullptr);
+    generator.detach();
+    SDL_Quit();
+
+    std::uint64_t sent = 0, dropped = 0;
+    for (std::size_t i = 0; i < stats.sent.size(); ++i) {
+        sent += stats.sent[i];
+        dropped += stats.dropped(static_cast<LoadInput>(i));
+    }
+    bool failed = false;
+    if (max_drop >= 0 && sent > 0 && static_cast<double>(dropped) / sent > max_drop) {
+        std::cout << "FAIL: dropped " << dropped << " of " << sent << " changes" << std::endl;
+        failed = true;
+    }
+    if (max_p99_us >= 0 && stats.latency_p99_us > max_p99_us) {
+        std::cout << "FAIL: p99 latency " << stats.latency_p99_us << " us" << std::endl;
+        failed = true;
+    }
+    return failed ? 1 : 0;
+}